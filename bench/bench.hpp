@@ -0,0 +1,49 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <nexus/error_code.hpp>
+
+// helpers shared by the benchmark programs
+
+namespace nexus::bench {
+
+using clock_type = std::chrono::steady_clock;
+
+/// return the iteration count from the first command-line argument, or the
+/// default. exits on parse errors
+inline size_t parse_iterations(int argc, char** argv)
+{
+  size_t value = 1000000;
+  if (argc > 1) {
+    const auto begin = argv[1];
+    const auto end = begin + strlen(begin);
+    const auto result = std::from_chars(begin, end, value);
+    if (auto ec = make_error_code(result.ec); ec) {
+      std::cerr << "failed to parse iterations \"" << argv[1]
+          << "\": " << ec.message() << '\n';
+      ::exit(EXIT_FAILURE);
+    }
+  }
+  return value;
+}
+
+/// call the function 'iterations' times and print the average time per call
+template <typename Function>
+void measure(const char* mode, const char* name, size_t iterations,
+             Function&& f)
+{
+  const auto start = clock_type::now();
+  for (size_t i = 0; i < iterations; i++) {
+    f();
+  }
+  const auto elapsed = clock_type::now() - start;
+  const auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  std::cout << mode << ' ' << name << ": "
+      << ns / iterations << " ns/op\n";
+}
+
+} // namespace nexus::bench
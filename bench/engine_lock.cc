@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <optional>
+#include <boost/asio/io_context.hpp>
+#include <nexus/global_init.hpp>
+#include <nexus/quic/client.hpp>
+#include <nexus/quic/connection.hpp>
+#include <nexus/quic/memory_network.hpp>
+#include <nexus/quic/server.hpp>
+#include <nexus/quic/stream.hpp>
+
+#include "bench.hpp"
+#include "certificate.hpp"
+
+// measures the per-operation cost of stream and connection calls with the
+// engine's mutex, and without it under settings::single_threaded. runs over
+// a memory_network so the results don't include system calls
+
+namespace {
+
+using namespace nexus;
+using bench::measure;
+using bench::parse_iterations;
+
+void run(const char* mode, bool single_threaded, size_t iterations)
+{
+  auto context = boost::asio::io_context{1};
+  auto ex = context.get_executor();
+
+  auto ssl = test::init_server_context("\04test");
+  auto sslc = test::init_client_context("\04test");
+
+  auto settings = quic::default_server_settings();
+  settings.single_threaded = single_threaded;
+  auto csettings = quic::default_client_settings();
+  csettings.single_threaded = single_threaded;
+
+  auto network = quic::memory_network{};
+  auto server = quic::server{ex, settings};
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto acceptor = quic::acceptor{server, network,
+                                 udp::endpoint{localhost, 0}, ssl};
+  acceptor.listen(16);
+
+  auto sconn = quic::connection{acceptor};
+  std::optional<error_code> accept_ec;
+  acceptor.async_accept(sconn, [&] (error_code ec) { accept_ec = ec; });
+
+  auto client = quic::client{ex, network, udp::endpoint{}, sslc, csettings};
+  auto cconn = quic::connection{client, acceptor.local_endpoint(), "host"};
+  auto cstream = quic::stream{cconn};
+  std::optional<error_code> connect_ec;
+  cconn.async_connect(cstream, [&] (error_code ec) { connect_ec = ec; });
+
+  context.poll();
+  if (!accept_ec || *accept_ec || !connect_ec || *connect_ec) {
+    std::cerr << mode << ": failed to connect\n";
+    ::exit(EXIT_FAILURE);
+  }
+
+  // calls that only lock the engine and inspect state
+  measure(mode, "connection::is_open()", iterations,
+          [&] { return cconn.is_open(); });
+  measure(mode, "stream::is_open()", iterations,
+          [&] { return cstream.is_open(); });
+  measure(mode, "stream::id()", iterations,
+          [&] { return cstream.id(); });
+
+  // echo a small buffer through the engines and the memory network
+  auto sstream = quic::stream{sconn};
+  std::optional<error_code> stream_accept_ec;
+  sconn.async_accept(sstream, [&] (error_code ec) { stream_accept_ec = ec; });
+
+  auto data = std::array<char, 16>{};
+  auto buffer = std::array<char, 16>{};
+  const size_t roundtrips = std::max<size_t>(iterations / 100, 1);
+  measure(mode, "stream write+read", roundtrips, [&] {
+      cstream.async_write_some(boost::asio::buffer(data),
+                               [] (error_code, size_t) {});
+      context.poll();
+      sstream.async_read_some(boost::asio::buffer(buffer),
+                              [] (error_code, size_t) {});
+      context.poll();
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  const size_t iterations = parse_iterations(argc, argv);
+  auto global = nexus::global::init_client_server();
+  run("locked", false, iterations);
+  run("single_threaded", true, iterations);
+  return 0;
+}
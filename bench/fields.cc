@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <boost/intrusive/set.hpp>
+#include <nexus/h3/fields.hpp>
+
+#include "bench.hpp"
+
+// compares h3::fields lookups against the red-black multiset index that it
+// used to keep, with names compared by std::tolower(), and lookup_token()
+// against the linear scan of the token names that it replaced
+
+namespace {
+
+using namespace nexus;
+using bench::measure;
+using bench::parse_iterations;
+
+// a typical request
+constexpr auto headers = std::array<std::pair<std::string_view,
+                                              std::string_view>, 12>{{
+  {":method", "GET"},
+  {":scheme", "https"},
+  {":authority", "example.com"},
+  {":path", "/api/v1/items?limit=10"},
+  {"user-agent", "nexus-bench/1.0"},
+  {"accept", "application/json"},
+  {"accept-encoding", "gzip, deflate, br"},
+  {"accept-language", "en-US,en;q=0.9"},
+  {"cache-control", "no-cache"},
+  {"cookie", "a=1"},
+  {"cookie", "b=2"},
+  {"x-request-id", "f81d4fae-7dec-11d0-a765-00a0c91e6bf6"},
+}};
+
+// names looked up by a request handler, including some that are missing
+constexpr auto lookups = std::array<std::string_view, 8>{
+  ":method", ":path", ":authority", "content-length",
+  "accept-encoding", "cookie", "authorization", "x-request-id",
+};
+
+// the previous index: a multiset ordered by case-insensitive comparison
+struct node : boost::intrusive::set_base_hook<> {
+  std::string_view name;
+  explicit node(std::string_view name) : name(name) {}
+};
+
+struct node_compare {
+  bool operator()(char lhs, char rhs) const {
+    return std::tolower(lhs) < std::tolower(rhs);
+  }
+  bool operator()(std::string_view lhs, std::string_view rhs) const {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                        rhs.begin(), rhs.end(), *this);
+  }
+};
+
+struct node_key {
+  using type = std::string_view;
+  type operator()(const node& n) { return n.name; }
+};
+
+using node_multiset = boost::intrusive::multiset<node,
+      boost::intrusive::compare<node_compare>,
+      boost::intrusive::key_of_value<node_key>>;
+
+void run_multiset(size_t iterations)
+{
+  auto nodes = std::vector<node>{};
+  nodes.reserve(headers.size());
+  auto set = node_multiset{};
+  for (const auto& [name, value] : headers) {
+    set.insert(nodes.emplace_back(name));
+  }
+  size_t found = 0;
+  measure("multiset", "find", iterations, [&] {
+      for (auto name : lookups) {
+        found += set.find(name) != set.end();
+      }
+    });
+  measure("multiset", "count", iterations, [&] {
+      for (auto name : lookups) {
+        found += set.count(name);
+      }
+    });
+  set.clear();
+  measure("multiset", "insert_clear", iterations, [&] {
+      for (auto& n : nodes) {
+        set.insert(n);
+      }
+      set.clear();
+    });
+  std::cout << "multiset found " << found << '\n';
+}
+
+// the previous lookup_token(): compare against every token name
+h3::field_token scan_token(std::string_view name)
+{
+  for (size_t i = 0; i < h3::detail::token_count; i++) {
+    const auto t = h3::detail::token_names[i];
+    if (t.size() == name.size() && h3::detail::field_name_equal(t, name)) {
+      return static_cast<h3::field_token>(i);
+    }
+  }
+  return h3::field_token::unknown;
+}
+
+void run_tokens(size_t iterations)
+{
+  size_t known = 0;
+  measure("scan", "lookup_token", iterations, [&] {
+      for (const auto& [name, value] : headers) {
+        known += scan_token(name) != h3::field_token::unknown;
+      }
+    });
+  measure("switch", "lookup_token", iterations, [&] {
+      for (const auto& [name, value] : headers) {
+        known += h3::lookup_token(name) != h3::field_token::unknown;
+      }
+    });
+  std::cout << "tokens known " << known << '\n';
+}
+
+void run_fields(size_t iterations)
+{
+  auto f = h3::fields{};
+  for (const auto& [name, value] : headers) {
+    f.insert(name, value);
+  }
+  size_t found = 0;
+  measure("fields", "find", iterations, [&] {
+      for (auto name : lookups) {
+        found += f.find(name) != f.end();
+      }
+    });
+  measure("fields", "count", iterations, [&] {
+      for (auto name : lookups) {
+        found += f.count(name);
+      }
+    });
+  // includes the allocation of each field, unlike the multiset
+  f.clear();
+  measure("fields", "insert_clear", iterations, [&] {
+      for (const auto& [name, value] : headers) {
+        f.insert(name, value);
+      }
+      f.clear();
+    });
+  std::cout << "fields found " << found << '\n';
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  const size_t iterations = parse_iterations(argc, argv);
+  run_multiset(iterations);
+  run_fields(iterations);
+  run_tokens(iterations);
+  return 0;
+}
@@ -82,14 +82,22 @@ void write_file(stream_ptr stream)
   auto& data = stream->writebuf;
   stream->input.read(data.data(), data.size());
   const auto bytes = stream->input.gcount();
-  // write to stream
   auto& s = stream->stream;
+  if (!stream->input) {
+    // no more input, so send the fin with the last of the data
+    s.async_write_last(boost::asio::buffer(data.data(), bytes),
+      [stream=std::move(stream)] (error_code ec, size_t bytes) {
+        if (ec) {
+          std::cerr << "async_write_last failed with " << ec.message() << '\n';
+        }
+      });
+    return;
+  }
+  // write to stream
   boost::asio::async_write(s, boost::asio::buffer(data.data(), bytes),
     [stream=std::move(stream)] (error_code ec, size_t bytes) {
       if (ec) {
         std::cerr << "async_write failed with " << ec.message() << '\n';
-      } else if (!stream->input) { // no more input, done writing
-        stream->stream.shutdown(1);
       } else {
         write_file(std::move(stream));
       }
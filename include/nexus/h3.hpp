@@ -7,4 +7,5 @@ namespace nexus::h3 {}
 #include <nexus/h3/error.hpp>
 #include <nexus/h3/fields.hpp>
 #include <nexus/h3/server.hpp>
+#include <nexus/h3/sharded_server.hpp>
 #include <nexus/h3/stream.hpp>
@@ -23,7 +23,8 @@ class client {
 
   /// construct the client, taking ownership of a bound UDP socket
   client(udp::socket&& socket, ssl::context& ctx,
-         const quic::settings& s);
+         const quic::settings& s,
+         quic::packet_io io = quic::packet_io::reactor);
 
   /// construct the client and bind a UDP socket to the given endpoint
   client(const executor_type& ex, const udp::endpoint& endpoint,
@@ -31,7 +32,19 @@ class client {
 
   /// construct the client and bind a UDP socket to the given endpoint
   client(const executor_type& ex, const udp::endpoint& endpoint,
-         ssl::context& ctx, const quic::settings& s);
+         ssl::context& ctx, const quic::settings& s,
+         quic::packet_io io = quic::packet_io::reactor);
+
+  /// construct the client and bind it to the given endpoint of an in-memory
+  /// network
+  client(const executor_type& ex, quic::memory_network& network,
+         const udp::endpoint& endpoint, ssl::context& ctx);
+
+  /// construct the client and bind it to the given endpoint of an in-memory
+  /// network
+  client(const executor_type& ex, quic::memory_network& network,
+         const udp::endpoint& endpoint, ssl::context& ctx,
+         const quic::settings& s);
 
   /// return the associated io executor
   executor_type get_executor() const;
@@ -39,6 +52,12 @@ class client {
   /// return the socket's locally-bound address/port
   udp::endpoint local_endpoint() const;
 
+  /// return the socket's packet counters
+  quic::socket_stats stats() const;
+
+  /// return the optional packet i/o features in use by the socket
+  quic::socket_features features() const;
+
   /// open a connection to the given remote endpoint and hostname. this
   /// initiates the TLS handshake, but returns immediately without waiting
   /// for the handshake to complete
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace nexus::h3 {
+
+/// well-known field names from the QPACK static table (RFC 9204 Appendix A).
+/// the pseudo-headers come first
+enum class field_token : uint8_t {
+  authority,
+  path,
+  method,
+  scheme,
+  status,
+  age,
+  content_disposition,
+  content_length,
+  cookie,
+  date,
+  etag,
+  if_modified_since,
+  if_none_match,
+  last_modified,
+  link,
+  location,
+  referer,
+  set_cookie,
+  accept,
+  accept_encoding,
+  accept_ranges,
+  access_control_allow_headers,
+  access_control_allow_origin,
+  cache_control,
+  content_encoding,
+  content_type,
+  range,
+  strict_transport_security,
+  vary,
+  x_content_type_options,
+  x_xss_protection,
+  accept_language,
+  access_control_allow_credentials,
+  access_control_allow_methods,
+  access_control_expose_headers,
+  access_control_request_headers,
+  access_control_request_method,
+  alt_svc,
+  authorization,
+  content_security_policy,
+  early_data,
+  expect_ct,
+  forwarded,
+  if_range,
+  origin,
+  purpose,
+  server,
+  timing_allow_origin,
+  upgrade_insecure_requests,
+  user_agent,
+  x_forwarded_for,
+  x_frame_options,
+  unknown, ///< not in the static table
+};
+
+namespace detail {
+
+// the number of pseudo-header tokens, which come first
+inline constexpr size_t pseudo_token_count = 5;
+
+inline constexpr size_t token_count =
+    static_cast<size_t>(field_token::unknown);
+
+// field names in token order
+inline constexpr auto token_names = std::array<std::string_view, token_count>{
+  ":authority",
+  ":path",
+  ":method",
+  ":scheme",
+  ":status",
+  "age",
+  "content-disposition",
+  "content-length",
+  "cookie",
+  "date",
+  "etag",
+  "if-modified-since",
+  "if-none-match",
+  "last-modified",
+  "link",
+  "location",
+  "referer",
+  "set-cookie",
+  "accept",
+  "accept-encoding",
+  "accept-ranges",
+  "access-control-allow-headers",
+  "access-control-allow-origin",
+  "cache-control",
+  "content-encoding",
+  "content-type",
+  "range",
+  "strict-transport-security",
+  "vary",
+  "x-content-type-options",
+  "x-xss-protection",
+  "accept-language",
+  "access-control-allow-credentials",
+  "access-control-allow-methods",
+  "access-control-expose-headers",
+  "access-control-request-headers",
+  "access-control-request-method",
+  "alt-svc",
+  "authorization",
+  "content-security-policy",
+  "early-data",
+  "expect-ct",
+  "forwarded",
+  "if-range",
+  "origin",
+  "purpose",
+  "server",
+  "timing-allow-origin",
+  "upgrade-insecure-requests",
+  "user-agent",
+  "x-forwarded-for",
+  "x-frame-options",
+};
+
+// the token of each entry's name in the QPACK static table
+inline constexpr auto qpack_static_tokens = [] {
+  using t = field_token;
+  return std::array<field_token, 99>{
+    t::authority, t::path, t::age, t::content_disposition, // 0-3
+    t::content_length, t::cookie, t::date, t::etag, // 4-7
+    t::if_modified_since, t::if_none_match, t::last_modified, // 8-10
+    t::link, t::location, t::referer, t::set_cookie, // 11-14
+    t::method, t::method, t::method, t::method, // 15-18
+    t::method, t::method, t::method, // 19-21
+    t::scheme, t::scheme, // 22-23
+    t::status, t::status, t::status, t::status, t::status, // 24-28
+    t::accept, t::accept, t::accept_encoding, t::accept_ranges, // 29-32
+    t::access_control_allow_headers, t::access_control_allow_headers, // 33-34
+    t::access_control_allow_origin, // 35
+    t::cache_control, t::cache_control, t::cache_control, // 36-38
+    t::cache_control, t::cache_control, t::cache_control, // 39-41
+    t::content_encoding, t::content_encoding, // 42-43
+    t::content_type, t::content_type, t::content_type, // 44-46
+    t::content_type, t::content_type, t::content_type, // 47-49
+    t::content_type, t::content_type, t::content_type, // 50-52
+    t::content_type, t::content_type, // 53-54
+    t::range, // 55
+    t::strict_transport_security, t::strict_transport_security, // 56-57
+    t::strict_transport_security, // 58
+    t::vary, t::vary, t::x_content_type_options, // 59-61
+    t::x_xss_protection, // 62
+    t::status, t::status, t::status, t::status, t::status, // 63-67
+    t::status, t::status, t::status, t::status, // 68-71
+    t::accept_language, // 72
+    t::access_control_allow_credentials, // 73
+    t::access_control_allow_credentials, // 74
+    t::access_control_allow_headers, // 75
+    t::access_control_allow_methods, // 76
+    t::access_control_allow_methods, // 77
+    t::access_control_allow_methods, // 78
+    t::access_control_expose_headers, // 79
+    t::access_control_request_headers, // 80
+    t::access_control_request_method, // 81
+    t::access_control_request_method, // 82
+    t::alt_svc, t::authorization, t::content_security_policy, // 83-85
+    t::early_data, t::expect_ct, t::forwarded, t::if_range, // 86-89
+    t::origin, t::purpose, t::server, t::timing_allow_origin, // 90-93
+    t::upgrade_insecure_requests, t::user_agent, // 94-95
+    t::x_forwarded_for, t::x_frame_options, t::x_frame_options, // 96-98
+  };
+}();
+
+// the value of each entry in the QPACK static table
+inline constexpr auto qpack_static_values = std::array<std::string_view, 99>{
+  "", "/", "0", "", "0", "", "", "", "", "", "", "", "", "", "", // 0-14
+  "CONNECT", "DELETE", "GET", "HEAD", "OPTIONS", "POST", "PUT", // 15-21
+  "http", "https", // 22-23
+  "103", "200", "304", "404", "503", // 24-28
+  "*/*", "application/dns-message", "gzip, deflate, br", "bytes", // 29-32
+  "cache-control", "content-type", "*", // 33-35
+  "max-age=0", "max-age=2592000", "max-age=604800", // 36-38
+  "no-cache", "no-store", "public, max-age=31536000", // 39-41
+  "br", "gzip", // 42-43
+  "application/dns-message", "application/javascript", // 44-45
+  "application/json", "application/x-www-form-urlencoded", // 46-47
+  "image/gif", "image/jpeg", "image/png", "text/css", // 48-51
+  "text/html; charset=utf-8", "text/plain", // 52-53
+  "text/plain;charset=utf-8", // 54
+  "bytes=0-", // 55
+  "max-age=31536000", // 56
+  "max-age=31536000; includesubdomains", // 57
+  "max-age=31536000; includesubdomains; preload", // 58
+  "accept-encoding", "origin", "nosniff", "1; mode=block", // 59-62
+  "100", "204", "206", "302", "400", "403", "421", "425", "500", // 63-71
+  "", "FALSE", "TRUE", "*", // 72-75
+  "get", "get, post, options", "options", // 76-78
+  "content-length", "content-type", "get", "post", // 79-82
+  "clear", "", // 83-84
+  "script-src 'none'; object-src 'none'; base-uri 'none'", // 85
+  "1", "", "", "", "", "prefetch", "", "*", "1", "", "", // 86-96
+  "deny", "sameorigin", // 97-98
+};
+
+} // namespace detail
+
+/// return the field name of a well-known token, or an empty string for
+/// field_token::unknown
+constexpr std::string_view token_name(field_token token)
+{
+  const auto i = static_cast<size_t>(token);
+  return i < detail::token_count ? detail::token_names[i] : std::string_view{};
+}
+
+/// return the token for the name of the given QPACK static table entry, or
+/// field_token::unknown if the index is out of range
+constexpr field_token qpack_static_token(unsigned index)
+{
+  return index < detail::qpack_static_tokens.size()
+      ? detail::qpack_static_tokens[index] : field_token::unknown;
+}
+
+/// return the index of the QPACK static table entry that matches the given
+/// name and value, or else the first entry that matches the name, or -1 if
+/// the name isn't in the table
+constexpr int qpack_static_index(field_token token, std::string_view value)
+{
+  int name_match = -1;
+  for (size_t i = 0; i < detail::qpack_static_tokens.size(); i++) {
+    if (detail::qpack_static_tokens[i] != token) {
+      continue;
+    }
+    if (detail::qpack_static_values[i] == value) {
+      return static_cast<int>(i);
+    }
+    if (name_match == -1) {
+      name_match = static_cast<int>(i);
+    }
+  }
+  return name_match;
+}
+
+} // namespace nexus::h3
@@ -1,31 +1,296 @@
 #pragma once
 
-#include <cctype>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
 #include <string_view>
+#include <utility>
 
-#include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
+#include <nexus/h3/field_token.hpp>
 
 namespace nexus::h3 {
 
-/// an immutable key/value pair to represent a single header
-class field : public boost::intrusive::list_base_hook<>,
-              public boost::intrusive::set_base_hook<>
+namespace detail {
+
+// fold the ASCII upper case letters in each byte of the word to lower case,
+// leaving other bytes unchanged
+inline uint64_t fold_case(uint64_t word)
+{
+  constexpr uint64_t ones = 0x0101010101010101;
+  const uint64_t low7 = word & (0x7f * ones);
+  // set the high bit of each byte that's at least 'A', and of each byte
+  // that's greater than 'Z'. neither addition carries into the next byte
+  const uint64_t ge_upper_a = low7 + (0x80 - 'A') * ones;
+  const uint64_t gt_upper_z = low7 + (0x80 - 'Z' - 1) * ones;
+  const uint64_t upper = ge_upper_a & ~gt_upper_z & ~word & (0x80 * ones);
+  return word | (upper >> 2); // add 0x20 to each upper case letter
+}
+
+// load up to 8 bytes into a zero-padded word
+inline uint64_t load_word(const char* data, size_t count)
+{
+  uint64_t word = 0;
+  std::memcpy(&word, data, count);
+  return word;
+}
+
+// case-insensitive hash of a field name. http/3 requires lower case names on
+// the wire, so folding is rarely needed, but it's done a word at a time
+inline uint32_t field_name_hash(std::string_view name)
+{
+  constexpr uint64_t mul = 0xff51afd7ed558ccd;
+  uint64_t h = 0x9e3779b97f4a7c15 ^ name.size();
+  auto p = name.data();
+  auto n = name.size();
+  for (; n >= 8; p += 8, n -= 8) {
+    h = (h ^ fold_case(load_word(p, 8))) * mul;
+    h ^= h >> 32;
+  }
+  if (n) {
+    h = (h ^ fold_case(load_word(p, n))) * mul;
+  }
+  h ^= h >> 29;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 32;
+  return static_cast<uint32_t>(h);
+}
+
+// case-insensitive field name comparison
+inline bool field_name_equal(std::string_view lhs, std::string_view rhs)
+{
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  auto l = lhs.data();
+  auto r = rhs.data();
+  auto n = lhs.size();
+  for (; n >= 8; l += 8, r += 8, n -= 8) {
+    if (fold_case(load_word(l, 8)) != fold_case(load_word(r, 8))) {
+      return false;
+    }
+  }
+  return n == 0 || fold_case(load_word(l, n)) == fold_case(load_word(r, n));
+}
+
+// fold an ASCII upper case letter to lower case
+inline char fold_char(char c)
 {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// return the token if its name matches, or field_token::unknown
+inline field_token match_token(std::string_view name, field_token token)
+{
+  return field_name_equal(token_names[static_cast<size_t>(token)], name)
+      ? token : field_token::unknown;
+}
+
+// return the first of the candidate tokens whose name matches
+inline field_token match_token(std::string_view name,
+                               std::initializer_list<field_token> candidates)
+{
+  for (auto t : candidates) {
+    if (field_name_equal(token_names[static_cast<size_t>(t)], name)) {
+      return t;
+    }
+  }
+  return field_token::unknown;
+}
+
+} // namespace detail
+
+/// return the token that matches the given name case-insensitively, or
+/// field_token::unknown
+inline field_token lookup_token(std::string_view name)
+{
+  // narrow the candidates by length and first character, so most names are
+  // compared against at most one token name. the fields.lookup_all_tokens
+  // test checks that every name in detail::token_names is reachable
+  switch (name.size()) {
+    case 3:
+      return detail::match_token(name, field_token::age);
+    case 4:
+      switch (detail::fold_char(name[0])) {
+        case 'd':
+          return detail::match_token(name, field_token::date);
+        case 'e':
+          return detail::match_token(name, field_token::etag);
+        case 'l':
+          return detail::match_token(name, field_token::link);
+        case 'v':
+          return detail::match_token(name, field_token::vary);
+        default: return field_token::unknown;
+      }
+    case 5:
+      switch (detail::fold_char(name[0])) {
+        case ':':
+          return detail::match_token(name, field_token::path);
+        case 'r':
+          return detail::match_token(name, field_token::range);
+        default: return field_token::unknown;
+      }
+    case 6:
+      switch (detail::fold_char(name[0])) {
+        case 'a':
+          return detail::match_token(name, field_token::accept);
+        case 'c':
+          return detail::match_token(name, field_token::cookie);
+        case 'o':
+          return detail::match_token(name, field_token::origin);
+        case 's':
+          return detail::match_token(name, field_token::server);
+        default: return field_token::unknown;
+      }
+    case 7:
+      switch (detail::fold_char(name[0])) {
+        case ':':
+          return detail::match_token(name, {
+              field_token::method,
+              field_token::scheme,
+              field_token::status});
+        case 'a':
+          return detail::match_token(name, field_token::alt_svc);
+        case 'p':
+          return detail::match_token(name, field_token::purpose);
+        case 'r':
+          return detail::match_token(name, field_token::referer);
+        default: return field_token::unknown;
+      }
+    case 8:
+      switch (detail::fold_char(name[0])) {
+        case 'i':
+          return detail::match_token(name, field_token::if_range);
+        case 'l':
+          return detail::match_token(name, field_token::location);
+        default: return field_token::unknown;
+      }
+    case 9:
+      switch (detail::fold_char(name[0])) {
+        case 'e':
+          return detail::match_token(name, field_token::expect_ct);
+        case 'f':
+          return detail::match_token(name, field_token::forwarded);
+        default: return field_token::unknown;
+      }
+    case 10:
+      switch (detail::fold_char(name[0])) {
+        case ':':
+          return detail::match_token(name, field_token::authority);
+        case 'e':
+          return detail::match_token(name, field_token::early_data);
+        case 's':
+          return detail::match_token(name, field_token::set_cookie);
+        case 'u':
+          return detail::match_token(name, field_token::user_agent);
+        default: return field_token::unknown;
+      }
+    case 12:
+      return detail::match_token(name, field_token::content_type);
+    case 13:
+      switch (detail::fold_char(name[0])) {
+        case 'a':
+          return detail::match_token(name, {
+              field_token::accept_ranges,
+              field_token::authorization});
+        case 'c':
+          return detail::match_token(name, field_token::cache_control);
+        case 'i':
+          return detail::match_token(name, field_token::if_none_match);
+        case 'l':
+          return detail::match_token(name, field_token::last_modified);
+        default: return field_token::unknown;
+      }
+    case 14:
+      return detail::match_token(name, field_token::content_length);
+    case 15:
+      switch (detail::fold_char(name[0])) {
+        case 'a':
+          return detail::match_token(name, {
+              field_token::accept_encoding,
+              field_token::accept_language});
+        case 'x':
+          return detail::match_token(name, {
+              field_token::x_forwarded_for,
+              field_token::x_frame_options});
+        default: return field_token::unknown;
+      }
+    case 16:
+      switch (detail::fold_char(name[0])) {
+        case 'c':
+          return detail::match_token(name, field_token::content_encoding);
+        case 'x':
+          return detail::match_token(name, field_token::x_xss_protection);
+        default: return field_token::unknown;
+      }
+    case 17:
+      return detail::match_token(name, field_token::if_modified_since);
+    case 19:
+      switch (detail::fold_char(name[0])) {
+        case 'c':
+          return detail::match_token(name, field_token::content_disposition);
+        case 't':
+          return detail::match_token(name, field_token::timing_allow_origin);
+        default: return field_token::unknown;
+      }
+    case 22:
+      return detail::match_token(name, field_token::x_content_type_options);
+    case 23:
+      return detail::match_token(name, field_token::content_security_policy);
+    case 25:
+      switch (detail::fold_char(name[0])) {
+        case 's':
+          return detail::match_token(
+              name, field_token::strict_transport_security);
+        case 'u':
+          return detail::match_token(
+              name, field_token::upgrade_insecure_requests);
+        default: return field_token::unknown;
+      }
+    case 27:
+      return detail::match_token(
+          name, field_token::access_control_allow_origin);
+    case 28:
+      return detail::match_token(name, {
+          field_token::access_control_allow_headers,
+          field_token::access_control_allow_methods});
+    case 29:
+      return detail::match_token(name, {
+          field_token::access_control_expose_headers,
+          field_token::access_control_request_method});
+    case 30:
+      return detail::match_token(
+          name, field_token::access_control_request_headers);
+    case 32:
+      return detail::match_token(
+          name, field_token::access_control_allow_credentials);
+    default: return field_token::unknown;
+  }
+}
+
+/// an immutable key/value pair to represent a single header
+class field : public boost::intrusive::list_base_hook<> {
   friend class fields;
   using size_type = uint16_t;
+  uint32_t hash; // case-insensitive hash of the name
   size_type name_size;
   size_type value_size;
   uint8_t never_index_;
+  field_token token_;
   char buffer[3]; // accounts for delimiter and null terminator
 
   static constexpr auto delim = std::string_view{": "};
 
   // private constructor, use the create() factory function instead
-  field(std::string_view name, std::string_view value, uint8_t never_index)
-      : name_size(name.size()), value_size(value.size()),
-        never_index_(never_index) {
+  field(std::string_view name, std::string_view value, uint8_t never_index,
+        field_token token)
+      : hash(detail::field_name_hash(name)),
+        name_size(name.size()), value_size(value.size()),
+        never_index_(never_index), token_(token) {
     auto pos = std::copy(name.begin(), name.end(), buffer);
     pos = std::copy(delim.begin(), delim.end(), pos);
     pos = std::copy(value.begin(), value.end(), pos);
@@ -49,6 +314,10 @@ class field : public boost::intrusive::list_base_hook<>,
   /// return whether or not this field can be cached for header compression
   bool never_index() const { return never_index_; }
 
+  /// return the well-known token for this field's name, or
+  /// field_token::unknown
+  field_token token() const { return token_; }
+
   /// return a null-terminated string of the form "<name>: <value>"
   const char* c_str() const { return buffer; }
   /// return a null-terminated string of the form "<name>: <value>"
@@ -58,30 +327,28 @@ class field : public boost::intrusive::list_base_hook<>,
 
  private:
   struct deleter {
+    std::pmr::memory_resource* resource;
     void operator()(field* f) {
       const size_t size = sizeof(field) + f->name_size + f->value_size;
-      using Alloc = std::allocator<char>;
-      using Traits = std::allocator_traits<Alloc>;
-      auto alloc = Alloc{};
-      Traits::destroy(alloc, f);
-      Traits::deallocate(alloc, reinterpret_cast<char*>(f), size);
+      f->~field();
+      resource->deallocate(f, size, alignof(field));
     }
   };
   using ptr = std::unique_ptr<field, deleter>;
 
-  // allocate just enough memory to hold the given name and value
-  static ptr create(std::string_view name, std::string_view value,
-                    bool never_index)
+  // allocate just enough memory from the resource to hold the given name and
+  // value
+  static ptr create(std::pmr::memory_resource* resource,
+                    std::string_view name, std::string_view value,
+                    bool never_index, field_token token)
   {
     const size_t size = sizeof(field) + name.size() + value.size();
-    using Alloc = std::allocator<char>;
-    using Traits = std::allocator_traits<Alloc>;
-    auto alloc = Alloc{};
-    auto p = Traits::allocate(alloc, size);
+    auto p = resource->allocate(size, alignof(field));
     try {
-      return ptr{new (p) field(name, value, never_index)};
+      return ptr{new (p) field(name, value, never_index, token),
+                 deleter{resource}};
     } catch (const std::exception&) {
-      Traits::deallocate(alloc, p, size);
+      resource->deallocate(p, size, alignof(field));
       throw;
     }
   }
@@ -89,35 +356,6 @@ class field : public boost::intrusive::list_base_hook<>,
 
 namespace detail {
 
-// case-insensitive field comparison for sorting in multiset
-struct field_compare {
-  bool operator()(char lhs, char rhs) const {
-    return std::tolower(lhs) < std::tolower(rhs);
-  }
-  bool operator()(std::string_view lhs, std::string_view rhs) const {
-    return std::lexicographical_compare(lhs.begin(), lhs.end(),
-                                        rhs.begin(), rhs.end(), *this);
-  }
-  bool operator()(const field& lhs, const field& rhs) const {
-    return (*this)(lhs.name(), rhs.name());
-  }
-  bool operator()(std::string_view lhs, const field& rhs) const {
-    return (*this)(lhs, rhs.name());
-  }
-  bool operator()(const field& lhs, std::string_view rhs) const {
-    return (*this)(lhs.name(), rhs);
-  }
-};
-
-struct field_key {
-  using type = std::string_view;
-  type operator()(const field& f) { return f.name(); }
-};
-
-using field_multiset = boost::intrusive::multiset<field,
-      boost::intrusive::compare<field_compare>,
-      boost::intrusive::key_of_value<field_key>>;
-
 using field_list = boost::intrusive::list<field,
       boost::intrusive::constant_time_size<true>,
       boost::intrusive::cache_last<true>,
@@ -126,26 +364,203 @@ using field_list = boost::intrusive::list<field,
 } // namespace detail
 
 /// an ordered list of headers for an http request or response. all field name
-/// comparisons are case-insensitive
+/// comparisons are case-insensitive. each field is allocated from the
+/// memory resource of the fields' allocator, so a monotonic_buffer_resource
+/// can hold all of a message's headers in one block
 class fields {
+ public:
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+ private:
+  allocator_type alloc;
   using list_type = detail::field_list;
   list_type list;
-  // maintain an index of the names for efficient searching
-  using multiset_type = detail::field_multiset;
-  multiset_type set;
+  // open-addressed hash index of the first field with each name. fields with
+  // the same name are kept adjacent in the list, so the rest follow it
+  field** slots = nullptr;
+  uint32_t capacity = 0; // a power of two, or 0
+  uint32_t names = 0; // number of occupied slots
+  // the first field of each pseudo-header, for constant-time access
+  std::array<field*, detail::pseudo_token_count> pseudo = {};
+
+  field::deleter deleter() const { return {alloc.resource()}; }
+
+  static bool same_name(const field& lhs, const field& rhs) {
+    return lhs.hash == rhs.hash
+        && detail::field_name_equal(lhs.name(), rhs.name());
+  }
+
+  // return the slot that indexes the given name, or the empty slot where it
+  // belongs. requires capacity > 0
+  field** find_slot(std::string_view name, uint32_t hash) const {
+    const uint32_t mask = capacity - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+      field* f = slots[i];
+      if (!f || (f->hash == hash &&
+                 detail::field_name_equal(f->name(), name))) {
+        return &slots[i];
+      }
+    }
+  }
+
+  // return the first field with the given name, or nullptr
+  field* lookup(std::string_view name) const {
+    if (names == 0) {
+      return nullptr;
+    }
+    return *find_slot(name, detail::field_name_hash(name));
+  }
+
+  // return the position after the last field with the same name as 'first'
+  template <typename Iterator>
+  Iterator run_end(Iterator first) const {
+    auto i = std::next(first);
+    while (i != list.end() && same_name(*i, *first)) {
+      ++i;
+    }
+    return i;
+  }
+
+  void rehash(uint32_t count) {
+    auto resource = alloc.resource();
+    auto p = static_cast<field**>(resource->allocate(
+            count * sizeof(field*), alignof(field*)));
+    std::fill(p, p + count, nullptr);
+    const uint32_t mask = count - 1;
+    for (uint32_t i = 0; i < capacity; i++) {
+      if (field* f = slots[i]; f) {
+        uint32_t j = f->hash & mask;
+        while (p[j]) {
+          j = (j + 1) & mask;
+        }
+        p[j] = f;
+      }
+    }
+    if (slots) {
+      resource->deallocate(slots, capacity * sizeof(field*), alignof(field*));
+    }
+    slots = p;
+    capacity = count;
+  }
+
+  // keep the load factor at or below 1/2 to bound the probe lengths
+  void reserve_slot() {
+    if ((names + 1) * 2 > capacity) {
+      rehash(capacity ? capacity * 2 : 8);
+    }
+  }
+
+  // empty the given slot, shifting back any entries that probed past it
+  void erase_slot(field** slot) {
+    const uint32_t mask = capacity - 1;
+    uint32_t i = slot - slots;
+    for (uint32_t j = (i + 1) & mask; slots[j]; j = (j + 1) & mask) {
+      const uint32_t home = slots[j]->hash & mask;
+      // leave entries whose home is cyclically within (i, j]
+      const bool skip = i <= j ? (i < home && home <= j)
+                               : (i < home || home <= j);
+      if (!skip) {
+        slots[i] = slots[j];
+        i = j;
+      }
+    }
+    slots[i] = nullptr;
+    --names;
+  }
+
+  void release_slots() {
+    if (slots) {
+      alloc.resource()->deallocate(slots, capacity * sizeof(field*),
+                                   alignof(field*));
+      slots = nullptr;
+      capacity = 0;
+      names = 0;
+    }
+  }
+
+  field** pseudo_slot(field_token token) {
+    const auto i = static_cast<size_t>(token);
+    return i < pseudo.size() ? &pseudo[i] : nullptr;
+  }
+
+  // set the first field with the given name, or nullptr
+  void set_first(field** slot, field_token token, field* f) {
+    if (auto p = pseudo_slot(token); p) {
+      *p = f;
+    }
+    if (f) {
+      *slot = f;
+    } else {
+      erase_slot(slot);
+    }
+  }
+
+  // copy the other fields' entries to the end of the list
+  void append(const fields& o) {
+    for (const auto& f : o.list) {
+      insert(f.name(), f.value(), f.never_index(), f.token());
+    }
+  }
+
+  std::string_view pseudo_value(field_token token) const {
+    const auto f = pseudo[static_cast<size_t>(token)];
+    return f ? f->value() : std::string_view{};
+  }
  public:
-  /// construct an empty list of fields
+  /// construct an empty list of fields that allocates from the default
+  /// memory resource
   fields() = default;
+  /// construct an empty list of fields that allocates from the given
+  /// allocator's memory resource
+  explicit fields(const allocator_type& alloc) : alloc(alloc) {}
   /// move-construct the fields, leaving o empty
-  fields(fields&& o) = default;
-  /// move-assign the fields, leaving o empty
+  fields(fields&& o) noexcept
+    : alloc(o.alloc), list(std::move(o.list)),
+      slots(std::exchange(o.slots, nullptr)),
+      capacity(std::exchange(o.capacity, 0)),
+      names(std::exchange(o.names, 0)),
+      pseudo(std::exchange(o.pseudo, {}))
+  {}
+  /// move-construct the fields with the given allocator. if it compares
+  /// unequal to o's allocator, o's fields are copied before it's cleared
+  fields(fields&& o, const allocator_type& alloc) : alloc(alloc) {
+    *this = std::move(o);
+  }
+  /// move-assign the fields, leaving o empty. if the allocators compare
+  /// unequal, o's fields are copied with this allocator before it's cleared
   fields& operator=(fields&& o) {
     clear();
-    list = std::move(o.list);
-    set = std::move(o.set);
+    if (alloc == o.alloc) {
+      release_slots();
+      list = std::move(o.list);
+      slots = std::exchange(o.slots, nullptr);
+      capacity = std::exchange(o.capacity, 0);
+      names = std::exchange(o.names, 0);
+      pseudo = std::exchange(o.pseudo, {});
+    } else {
+      append(o);
+      o.clear();
+    }
     return *this;
   }
-  ~fields() { clear(); }
+  ~fields() {
+    clear();
+    release_slots();
+  }
+
+  /// exchange the fields and their name index with o's. the allocators
+  /// must compare equal
+  void swap(fields& o) noexcept {
+    assert(alloc == o.alloc);
+    list.swap(o.list);
+    std::swap(slots, o.slots);
+    std::swap(capacity, o.capacity);
+    std::swap(names, o.names);
+    std::swap(pseudo, o.pseudo);
+  }
+  friend void swap(fields& lhs, fields& rhs) noexcept { lhs.swap(rhs); }
+
+  /// return the allocator used for each field
+  allocator_type get_allocator() const { return alloc; }
 
   using size_type = list_type::size_type;
   /// return the total number of fields in the list
@@ -167,37 +582,73 @@ class fields {
 
   /// return the number of fields that match the given name
   size_type count(std::string_view name) const {
-    return set.count(name);
+    auto f = lookup(name);
+    if (!f) {
+      return 0;
+    }
+    auto first = list.iterator_to(*f);
+    return std::distance(first, run_end(first));
   }
 
   /// return an iterator to the first field that matches the given name
   iterator find(std::string_view name) {
-    if (auto i = set.find(name); i != set.end()) {
-      return list.iterator_to(*i);
+    if (auto f = lookup(name); f) {
+      return list.iterator_to(*f);
     }
     return list.end();
   }
 
   /// return an iterator to the first field that matches the given name
   const_iterator find(std::string_view name) const {
-    if (auto i = set.find(name); i != set.end()) {
-      return list.iterator_to(*i);
+    if (auto f = lookup(name); f) {
+      return list.iterator_to(*f);
     }
     return list.end();
   }
 
+  /// return an iterator to the first field with the given token's name. this
+  /// takes constant time for pseudo-headers
+  iterator find(field_token token) {
+    if (auto p = pseudo_slot(token); p) {
+      return *p ? list.iterator_to(**p) : list.end();
+    }
+    return find(token_name(token));
+  }
+
+  /// return an iterator to the first field with the given token's name. this
+  /// takes constant time for pseudo-headers
+  const_iterator find(field_token token) const {
+    const auto i = static_cast<size_t>(token);
+    if (i < pseudo.size()) {
+      return pseudo[i] ? list.iterator_to(*pseudo[i]) : list.end();
+    }
+    return find(token_name(token));
+  }
+
+  /// return the value of the :method pseudo-header, or an empty string
+  std::string_view method() const { return pseudo_value(field_token::method); }
+  /// return the value of the :scheme pseudo-header, or an empty string
+  std::string_view scheme() const { return pseudo_value(field_token::scheme); }
+  /// return the value of the :authority pseudo-header, or an empty string
+  std::string_view authority() const {
+    return pseudo_value(field_token::authority);
+  }
+  /// return the value of the :path pseudo-header, or an empty string
+  std::string_view path() const { return pseudo_value(field_token::path); }
+  /// return the value of the :status pseudo-header, or an empty string
+  std::string_view status() const { return pseudo_value(field_token::status); }
+
   /// return an iterator pair corresponding to the range of fields that match
   /// the given name (the first match and one-past the last match)
   auto equal_range(std::string_view name)
       -> std::pair<iterator, iterator>
   {
-    auto lower = set.lower_bound(name);
-    if (lower == set.end()) {
+    auto f = lookup(name);
+    if (!f) {
       return {list.end(), list.end()};
     }
-    auto upper = set.upper_bound(name);
-    auto list_upper = std::next(list.iterator_to(*std::prev(upper)));
-    return {list.iterator_to(*lower), list_upper};
+    auto first = list.iterator_to(*f);
+    return {first, run_end(first)};
   }
 
   /// return an iterator pair corresponding to the range of fields that match
@@ -205,13 +656,12 @@ class fields {
   auto equal_range(std::string_view name) const
       -> std::pair<const_iterator, const_iterator>
   {
-    auto lower = set.lower_bound(name);
-    if (lower == set.end()) {
+    auto f = lookup(name);
+    if (!f) {
       return {list.end(), list.end()};
     }
-    auto upper = set.upper_bound(name);
-    auto list_upper = std::next(list.iterator_to(*std::prev(upper)));
-    return {list.iterator_to(*lower), list_upper};
+    auto first = list.iterator_to(*f);
+    return {first, run_end(first)};
   }
 
   /// insert the given field after the last field that matches its name, or at
@@ -219,17 +669,36 @@ class fields {
   iterator insert(std::string_view name, std::string_view value,
                   bool never_index = false)
   {
-    auto ptr = field::create(name, value, never_index);
+    return insert(name, value, never_index, lookup_token(name));
+  }
 
-    auto lower = set.lower_bound(name);
-    if (lower == set.end()) {
-      set.insert(set.end(), *ptr);
+  /// insert a field with the given token's name
+  iterator insert(field_token token, std::string_view value,
+                  bool never_index = false)
+  {
+    return insert(token_name(token), value, never_index, token);
+  }
+
+  /// insert a field whose name is already known to match the given token,
+  /// such as one decoded with a reference to the QPACK static table
+  iterator insert(std::string_view name, std::string_view value,
+                  bool never_index, field_token token)
+  {
+    auto ptr = field::create(alloc.resource(), name, value,
+                             never_index, token);
+
+    reserve_slot();
+    auto slot = find_slot(name, ptr->hash);
+    if (!*slot) {
+      *slot = ptr.get();
+      ++names;
+      if (auto p = pseudo_slot(token); p) {
+        *p = ptr.get();
+      }
       return list.insert(list.end(), *ptr.release());
     }
-    auto upper = set.upper_bound(name);
-    auto list_upper = std::next(list.iterator_to(*std::prev(upper)));
-    set.insert(upper, *ptr);
-    return list.insert(list_upper, *ptr.release());
+    auto upper = run_end(list.iterator_to(**slot));
+    return list.insert(upper, *ptr.release());
   }
 
   /// insert the given field at the end of the list, erasing any existing fields
@@ -237,40 +706,50 @@ class fields {
   iterator assign(std::string_view name, std::string_view value,
                   bool never_index = false)
   {
-    auto ptr = field::create(name, value, never_index);
-
-    auto lower = set.lower_bound(name);
-    if (lower == set.end()) {
-      set.insert(set.end(), *ptr);
-      return list.insert(list.end(), *ptr.release());
+    const auto token = lookup_token(name);
+    auto ptr = field::create(alloc.resource(), name, value,
+                             never_index, token);
+
+    reserve_slot();
+    auto slot = find_slot(name, ptr->hash);
+    if (!*slot) {
+      ++names;
+    } else {
+      auto lower = list.iterator_to(**slot);
+      list.erase_and_dispose(lower, run_end(lower), deleter());
+    }
+    *slot = ptr.get();
+    if (auto p = pseudo_slot(token); p) {
+      *p = ptr.get();
     }
-    auto upper = set.upper_bound(name);
-    auto list_lower = list.iterator_to(*lower);
-    auto list_upper = std::next(list.iterator_to(*std::prev(upper)));
-    set.erase(lower, upper);
-    list.erase_and_dispose(list_lower, list_upper, field::deleter{});
-
-    set.insert(set.end(), *ptr);
     return list.insert(list.end(), *ptr.release());
   }
 
   /// erase the field at the given position
   iterator erase(iterator p) {
-    set.erase(set.iterator_to(*p));
-    return list.erase_and_dispose(p, field::deleter{});
+    auto slot = find_slot(p->name(), p->hash);
+    if (*slot == &*p) { // update the index if p was the first of its name
+      auto next = std::next(p);
+      const bool more = next != list.end() && same_name(*next, *p);
+      set_first(slot, p->token(), more ? &*next : nullptr);
+    }
+    return list.erase_and_dispose(p, deleter());
   }
 
   /// erase all fields in the range [begin,end)
   iterator erase(iterator begin, iterator end) {
-    set.erase(set.iterator_to(*begin),
-              std::next(set.iterator_to(*std::prev(end))));
-    return list.erase_and_dispose(begin, end, field::deleter{});
+    while (begin != end) {
+      begin = erase(begin);
+    }
+    return begin;
   }
 
   /// erase all fields
   void clear() {
-    set.clear();
-    list.clear_and_dispose(field::deleter{});
+    list.clear_and_dispose(deleter());
+    std::fill(slots, slots + capacity, nullptr);
+    names = 0;
+    pseudo = {};
   }
 };
 
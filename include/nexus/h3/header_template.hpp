@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <nexus/h3/fields.hpp>
+
+namespace nexus::h3 {
+
+/// an immutable set of header fields that are shared by many messages, such
+/// as the content-type, server and cache-control of an api's responses. the
+/// fields are prepared once for header compression, so each message only
+/// encodes the fields that vary, like :status and content-length
+///
+/// when written with a message's fields, the template's pseudo-headers are
+/// sent first, then the message's fields, then the template's other fields.
+/// template fields whose name is also in the message's fields are skipped, so
+/// a message can override them
+class header_template {
+ public:
+  /// a field with its precomputed QPACK static table reference
+  struct entry {
+    const field* f;
+    int qpack_index; ///< static table index, or -1
+  };
+
+  /// copy the given fields into the template
+  explicit header_template(const fields& f) {
+    // pseudo-headers must come before any regular fields
+    for (const auto& i : f) {
+      if (is_pseudo(i)) {
+        storage.insert(i.name(), i.value(), i.never_index(), i.token());
+        ++pseudo_count;
+      }
+    }
+    for (const auto& i : f) {
+      if (!is_pseudo(i)) {
+        storage.insert(i.name(), i.value(), i.never_index(), i.token());
+      }
+    }
+    entries_.reserve(storage.size());
+    for (const auto& i : storage) {
+      entries_.push_back({&i, qpack_static_index(i.token(), i.value())});
+    }
+  }
+
+  // the entries point into storage, so copies would have to rebuild them.
+  // moves keep the fields where they are
+  header_template(const header_template&) = delete;
+  header_template& operator=(const header_template&) = delete;
+
+  header_template(header_template&& o) noexcept
+    : storage(std::move(o.storage)),
+      entries_(std::move(o.entries_)),
+      pseudo_count(std::exchange(o.pseudo_count, 0))
+  {}
+  header_template& operator=(header_template&& o) {
+    storage = std::move(o.storage);
+    entries_ = std::move(o.entries_);
+    pseudo_count = std::exchange(o.pseudo_count, 0);
+    return *this;
+  }
+
+  /// return the template's fields
+  const h3::fields& fields() const { return storage; }
+
+  /// return the number of fields in the template
+  size_t size() const { return entries_.size(); }
+
+  /// return the entries of the template's pseudo-headers
+  const entry* pseudo_begin() const { return entries_.data(); }
+  const entry* pseudo_end() const { return entries_.data() + pseudo_count; }
+
+  /// return the entries of the template's regular fields
+  const entry* regular_begin() const { return pseudo_end(); }
+  const entry* regular_end() const {
+    return entries_.data() + entries_.size();
+  }
+
+ private:
+  h3::fields storage;
+  std::vector<entry> entries_;
+  size_t pseudo_count = 0;
+
+  static bool is_pseudo(const field& f) {
+    return !f.name().empty() && f.name().front() == ':';
+  }
+};
+
+} // namespace nexus::h3
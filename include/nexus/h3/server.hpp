@@ -3,6 +3,7 @@
 #include <nexus/udp.hpp>
 #include <nexus/ssl.hpp>
 #include <nexus/quic/server.hpp>
+#include <nexus/h3/fields.hpp>
 
 namespace nexus::h3 {
 
@@ -44,10 +45,17 @@ class acceptor {
   using executor_type = quic::detail::socket_impl::executor_type;
 
   /// construct the acceptor, taking ownership of a bound UDP socket
-  acceptor(server& s, udp::socket&& socket, ssl::context& ctx);
+  acceptor(server& s, udp::socket&& socket, ssl::context& ctx,
+           quic::packet_io io = quic::packet_io::reactor);
 
   /// construct the acceptor and bind a UDP socket to the given endpoint
-  acceptor(server& s, const udp::endpoint& endpoint, ssl::context& ctx);
+  acceptor(server& s, const udp::endpoint& endpoint, ssl::context& ctx,
+           quic::packet_io io = quic::packet_io::reactor);
+
+  /// construct the acceptor and bind it to the given endpoint of an
+  /// in-memory network
+  acceptor(server& s, quic::memory_network& network,
+           const udp::endpoint& endpoint, ssl::context& ctx);
 
   /// return the associated io executor
   executor_type get_executor() const;
@@ -55,6 +63,12 @@ class acceptor {
   /// return the socket's locally-bound address/port
   udp::endpoint local_endpoint() const;
 
+  /// return the socket's packet counters
+  quic::socket_stats stats() const;
+
+  /// return the optional packet i/o features in use by the socket
+  quic::socket_features features() const;
+
   /// start receiving packets on the socket. incoming connections can be
   /// accepted with accept()/async_accept(). if the queue of unaccepted
   /// connections reaches 'backlog' in size, new connections are rejected
@@ -118,6 +132,21 @@ class server_connection {
   /// \overload
   void accept(stream& s);
 
+  /// accept an incoming stream and read its request headers. completes once
+  /// the headers are decoded, saving a separate call to
+  /// stream::async_read_headers(). the bool is true if the stream ended with
+  /// the headers, so the request has no body to read
+  template <typename CompletionToken> // void(error_code, bool)
+  decltype(auto) async_accept_request(stream& s, fields& f,
+                                      CompletionToken&& token) {
+    return impl.async_accept_request<stream>(
+        s, f, std::forward<CompletionToken>(token));
+  }
+  /// \overload
+  bool accept_request(stream& s, fields& f, error_code& ec);
+  /// \overload
+  bool accept_request(stream& s, fields& f);
+
   // TODO: push stream
 
   /// send a GOAWAY frame and stop initiating or accepting new streams
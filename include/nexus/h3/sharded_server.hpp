@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <nexus/udp.hpp>
+#include <nexus/ssl.hpp>
+#include <nexus/h3/server.hpp>
+#include <nexus/quic/detail/sharded_server_impl.hpp>
+
+namespace nexus::h3 {
+
+/// an HTTP/3 server that runs a separate server, acceptor and io_context
+/// thread per shard, with each thread pinned to its own cpu. the shards'
+/// sockets share a port with SO_REUSEPORT, and each connection's packets are
+/// steered back to the shard that accepted it by the first byte of its
+/// connection id. accepted connections from every shard are claimed with
+/// accept()/async_accept(), and remain associated with their shard's executor.
+/// claimed connections must be destroyed before the sharded_server
+class sharded_server {
+  quic::detail::sharded_server_impl<server, acceptor,
+                                    server_connection> impl;
+ public:
+  /// the polymorphic executor type, boost::asio::any_io_executor
+  using executor_type = boost::asio::any_io_executor;
+
+  /// construct the shards with default_server_settings() and bind their
+  /// sockets to the given endpoint. if num_shards is 0, start one shard per
+  /// available cpu. accept completions are delivered to the given executor
+  /// by default
+  sharded_server(const executor_type& ex, const udp::endpoint& endpoint,
+                 ssl::context& ctx, unsigned num_shards = 0);
+
+  /// construct the shards with the given settings and bind their sockets to
+  /// the given endpoint. throws bad_setting for settings::single_threaded,
+  /// because accepted connections are used outside of their shard's thread
+  sharded_server(const executor_type& ex, const udp::endpoint& endpoint,
+                 ssl::context& ctx, const quic::settings& s,
+                 unsigned num_shards = 0);
+
+  /// return the associated io executor
+  executor_type get_executor() const;
+
+  /// return the number of shards
+  unsigned size() const;
+
+  /// return the sockets' shared address/port
+  udp::endpoint local_endpoint() const;
+
+  /// start each shard's thread and its acceptor's listener. if the queue of
+  /// unclaimed connections reaches 'backlog' in size, the shards stop
+  /// accepting until accept() makes room. throws if the server is already
+  /// listening or was closed
+  void listen(int backlog);
+
+  /// claim the next connection accepted by any shard
+  template <typename CompletionToken> // void(error_code, std::unique_ptr<server_connection>)
+  decltype(auto) async_accept(CompletionToken&& token) {
+    return impl.async_accept(std::forward<CompletionToken>(token));
+  }
+
+  /// claim the next connection accepted by any shard
+  std::unique_ptr<server_connection> accept(error_code& ec);
+  /// \overload
+  std::unique_ptr<server_connection> accept();
+
+  /// close each shard's acceptor and server, and join their threads.
+  /// connections that were already claimed no longer make progress, and
+  /// must still be destroyed before the sharded_server. must not be called
+  /// from one of the shards' threads
+  void close();
+};
+
+} // namespace nexus::h3
@@ -2,6 +2,7 @@
 
 #include <nexus/quic/stream.hpp>
 #include <nexus/h3/fields.hpp>
+#include <nexus/h3/header_template.hpp>
 
 namespace nexus::h3 {
 
@@ -43,6 +44,105 @@ class stream : public quic::stream {
   void write_headers(const fields& f, error_code& ec);
   /// \overload
   void write_headers(const fields& f);
+
+  /// write response headers followed by all of the given body buffers, and
+  /// shut down the stream for writes if fin is true. the headers and the
+  /// start of the body are written in the same pass, so a small response can
+  /// go out in a single packet. completes with the number of body bytes
+  /// written
+  template <typename ConstBufferSequence,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_write_response(const fields& f,
+                                      const ConstBufferSequence& buffers,
+                                      bool fin, CompletionToken&& token) {
+    return impl.async_write_message(nullptr, f, buffers, fin,
+                                    std::forward<CompletionToken>(token));
+  }
+
+  /// write response headers followed by all of the given body buffers
+  template <typename ConstBufferSequence>
+  size_t write_response(const fields& f, const ConstBufferSequence& buffers,
+                        bool fin, error_code& ec) {
+    return impl.write_message(nullptr, f, buffers, fin, ec);
+  }
+  /// \overload
+  template <typename ConstBufferSequence>
+  size_t write_response(const fields& f, const ConstBufferSequence& buffers,
+                        bool fin) {
+    error_code ec;
+    const size_t bytes = impl.write_message(nullptr, f, buffers, fin, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
+
+  /// write response headers from a template and the given fields, followed
+  /// by all of the given body buffers. the template's static table references
+  /// are reused, so only the given fields, such as :status and
+  /// content-length, are examined for this response. a given field replaces
+  /// any template fields of the same name. completes with the number of body
+  /// bytes written
+  template <typename ConstBufferSequence,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_write_response(const header_template& t,
+                                      const fields& f,
+                                      const ConstBufferSequence& buffers,
+                                      bool fin, CompletionToken&& token) {
+    return impl.async_write_message(&t, f, buffers, fin,
+                                    std::forward<CompletionToken>(token));
+  }
+
+  /// write response headers from a template and the given fields, followed
+  /// by all of the given body buffers
+  template <typename ConstBufferSequence>
+  size_t write_response(const header_template& t, const fields& f,
+                        const ConstBufferSequence& buffers,
+                        bool fin, error_code& ec) {
+    return impl.write_message(&t, f, buffers, fin, ec);
+  }
+  /// \overload
+  template <typename ConstBufferSequence>
+  size_t write_response(const header_template& t, const fields& f,
+                        const ConstBufferSequence& buffers, bool fin) {
+    error_code ec;
+    const size_t bytes = impl.write_message(&t, f, buffers, fin, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
+
+  /// write request headers followed by all of the given body buffers, and
+  /// shut down the stream for writes if fin is true. the headers and the
+  /// start of the body are written in the same pass. completes with the
+  /// number of body bytes written
+  template <typename ConstBufferSequence,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_write_request(const fields& f,
+                                     const ConstBufferSequence& buffers,
+                                     bool fin, CompletionToken&& token) {
+    return impl.async_write_message(nullptr, f, buffers, fin,
+                                    std::forward<CompletionToken>(token));
+  }
+
+  /// write request headers followed by all of the given body buffers
+  template <typename ConstBufferSequence>
+  size_t write_request(const fields& f, const ConstBufferSequence& buffers,
+                       bool fin, error_code& ec) {
+    return impl.write_message(nullptr, f, buffers, fin, ec);
+  }
+  /// \overload
+  template <typename ConstBufferSequence>
+  size_t write_request(const fields& f, const ConstBufferSequence& buffers,
+                       bool fin) {
+    error_code ec;
+    const size_t bytes = impl.write_message(nullptr, f, buffers, fin, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
 };
 
 } // namespace nexus::h3
@@ -5,6 +5,8 @@ namespace nexus::quic {}
 
 #include <nexus/quic/client.hpp>
 #include <nexus/quic/server.hpp>
+#include <nexus/quic/sharded_server.hpp>
+#include <nexus/quic/memory_network.hpp>
 #include <nexus/quic/socket.hpp>
 #include <nexus/quic/connection.hpp>
 #include <nexus/quic/error.hpp>
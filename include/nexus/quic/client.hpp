@@ -2,6 +2,7 @@
 
 #include <nexus/udp.hpp>
 #include <nexus/ssl.hpp>
+#include <nexus/quic/memory_network.hpp>
 #include <nexus/quic/detail/engine_impl.hpp>
 #include <nexus/quic/detail/socket_impl.hpp>
 
@@ -24,7 +25,8 @@ class client {
   client(udp::socket&& socket, ssl::context& ctx); // TODO: noexcept
 
   /// construct the client, taking ownership of a bound UDP socket
-  client(udp::socket&& socket, ssl::context& ctx, const settings& s); // TODO: noexcept
+  client(udp::socket&& socket, ssl::context& ctx, const settings& s,
+         packet_io io = packet_io::reactor); // TODO: noexcept
 
   /// construct the client and bind a UDP socket to the given endpoint
   client(const executor_type& ex, const udp::endpoint& endpoint,
@@ -32,7 +34,19 @@ class client {
 
   /// construct the client and bind a UDP socket to the given endpoint
   client(const executor_type& ex, const udp::endpoint& endpoint,
-         ssl::context& ctx, const settings& s);
+         ssl::context& ctx, const settings& s,
+         packet_io io = packet_io::reactor);
+
+  /// construct the client and bind it to the given endpoint of an in-memory
+  /// network
+  client(const executor_type& ex, memory_network& network,
+         const udp::endpoint& endpoint, ssl::context& ctx);
+
+  /// construct the client and bind it to the given endpoint of an in-memory
+  /// network
+  client(const executor_type& ex, memory_network& network,
+         const udp::endpoint& endpoint, ssl::context& ctx,
+         const settings& s);
 
   /// return the associated io executor
   executor_type get_executor() const;
@@ -40,6 +54,12 @@ class client {
   /// return the socket's locally-bound address/port
   udp::endpoint local_endpoint() const;
 
+  /// return the socket's packet counters
+  socket_stats stats() const;
+
+  /// return the optional packet i/o features in use by the socket
+  socket_features features() const;
+
   /// open a connection to the given remote endpoint and hostname. this
   /// initiates the TLS handshake, but returns immediately without waiting
   /// for the handshake to complete
@@ -66,6 +66,24 @@ struct connection_impl : public connection_context,
         }, token);
   }
 
+  void accept_request(stream_accept_request_operation& op);
+
+  template <typename Stream, typename CompletionToken>
+  decltype(auto) async_accept_request(Stream& stream, h3::fields& fields,
+                                      CompletionToken&& token) {
+    auto& s = stream.impl;
+    return boost::asio::async_initiate<CompletionToken, void(error_code, bool)>(
+        [this, &s, &fields] (auto h) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_accept_request_async<Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor(),
+                                             s, fields);
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          accept_request(*op);
+          op.release(); // release ownership
+        }, token);
+  }
+
   bool is_open() const;
 
   void go_away(error_code& ec);
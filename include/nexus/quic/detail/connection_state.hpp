@@ -13,6 +13,7 @@ namespace nexus::quic::detail {
 
 struct accept_operation;
 struct stream_accept_operation;
+struct stream_accept_request_operation;
 struct stream_connect_operation;
 
 using stream_list = boost::intrusive::list<stream_impl>;
@@ -118,6 +119,8 @@ stream_impl* on_stream_connect(variant& state, lsquic_stream* handle,
                                bool is_http);
 
 void stream_accept(variant& state, stream_accept_operation& op, bool is_http);
+bool stream_accept_request(variant& state,
+                           stream_accept_request_operation& op);
 stream_impl* on_stream_accept(variant& state, lsquic_stream* handle,
                               bool is_http);
 
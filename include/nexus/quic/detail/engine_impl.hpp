@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <boost/asio/steady_timer.hpp>
 
@@ -15,24 +16,61 @@ struct lsquic_out_spec;
 namespace nexus::quic::detail {
 
 struct connection_impl;
+struct recv_header_set;
 struct stream_impl;
 struct socket_impl;
 
 struct engine_deleter { void operator()(lsquic_engine* e) const; };
 using lsquic_engine_ptr = std::unique_ptr<lsquic_engine, engine_deleter>;
 
+/// a mutex whose locking can be disabled when the engine is only ever
+/// accessed from a single thread, as with settings::single_threaded
+class engine_mutex {
+  std::mutex m;
+  bool enabled = true;
+ public:
+  /// stop locking. must be called before the mutex is shared
+  void disable() { enabled = false; }
+
+  void lock() { if (enabled) m.lock(); }
+  bool try_lock() { return !enabled || m.try_lock(); }
+  void unlock() { if (enabled) m.unlock(); }
+};
+
+using engine_lock = std::unique_lock<engine_mutex>;
+
 struct engine_impl {
-  mutable std::mutex mutex;
+  mutable engine_mutex mutex;
   boost::asio::any_io_executor ex;
-  boost::asio::steady_timer timer;
+  using timer_type = boost::asio::steady_timer;
+  timer_type timer;
+  // the timer is only re-armed when the next advisory tick moves earlier
+  timer_type::time_point timer_expiry;
+  bool timer_armed = false;
+  // header sets are reused between received messages to avoid allocating
+  // one each time. declared before the handle so that it outlives the header
+  // sets that lsquic discards during destruction
+  std::vector<std::unique_ptr<recv_header_set>> free_header_sets;
+  // limits on the free list, so a burst of streams or one oversized header
+  // doesn't pin that memory for the life of the engine
+  static constexpr size_t max_free_header_sets = 64;
+  static constexpr size_t max_free_header_buffer = 4096;
   lsquic_engine_ptr handle;
   // pointer to client socket or null if server
   socket_impl* client;
   uint32_t max_streams_per_connection;
   bool is_http;
+  settings config; // effective settings
+  bool process_pending = false; // deferred process() is scheduled
 
-  void process(std::unique_lock<std::mutex>& lock);
-  void reschedule(std::unique_lock<std::mutex>& lock);
+  void process(engine_lock& lock);
+  // process now, or on the next turn of the event loop with
+  // settings::deferred_processing
+  void request_process(engine_lock& lock);
+  void reschedule(engine_lock& lock);
+  // wait for the given expiry, unless the timer is already armed for an
+  // earlier one
+  void arm_timer(timer_type::time_point expiry);
   void on_timer();
 
   engine_impl(const boost::asio::any_io_executor& ex, socket_impl* client,
@@ -47,6 +85,11 @@ struct engine_impl {
   int send_packets(const lsquic_out_spec *specs, unsigned n_specs);
 
   stream_impl* on_new_stream(connection_impl& c, lsquic_stream* stream);
+
+  // take a header set from the free list, or allocate one if it's empty
+  recv_header_set* acquire_header_set(int is_push_promise);
+  // clear the header set and return it to the free list
+  void release_header_set(recv_header_set* headers);
 };
 
 } // namespace nexus::quic::detail
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <nexus/error_code.hpp>
+
+namespace nexus::quic::detail {
+
+/// a read-only memory mapping of a byte range of a file
+class mapped_file {
+  void* addr = nullptr; // start of the page-aligned mapping
+  size_t mapped_size = 0;
+  const unsigned char* begin = nullptr; // start of the requested range
+  size_t length = 0;
+ public:
+  mapped_file() = default;
+  /// map 'length' bytes of the open file, starting at 'offset'. the range
+  /// must lie within the file. the file descriptor may be closed afterward
+  mapped_file(int fd, uint64_t offset, size_t length, error_code& ec);
+  /// open the file at the given path and map a range of it
+  mapped_file(const char* path, uint64_t offset, size_t length,
+              error_code& ec);
+  ~mapped_file();
+
+  mapped_file(mapped_file&& o) noexcept;
+  mapped_file& operator=(mapped_file&& o) noexcept;
+
+  const unsigned char* data() const { return begin; }
+  size_t size() const { return length; }
+};
+
+/// a stream write source that reads from a mapped file
+struct mapped_file_source {
+  mapped_file file;
+  size_t offset = 0;
+
+  size_t size() const { return file.size() - offset; }
+  size_t read(void* data, size_t count);
+};
+
+} // namespace nexus::quic::detail
@@ -6,9 +6,12 @@
 #include <optional>
 #include <sys/uio.h>
 #include <boost/asio/associated_executor.hpp>
+#include <boost/asio/buffer.hpp>
 #include <nexus/error_code.hpp>
 #include <nexus/h3/fields.hpp>
+#include <nexus/h3/header_template.hpp>
 #include <nexus/quic/detail/handler_ptr.hpp>
+#include <nexus/quic/detail/mapped_file.hpp>
 
 namespace nexus::quic::detail {
 
@@ -212,12 +215,35 @@ using stream_accept_async = async_operation<
     stream_accept_operation, Handler, IoExecutor>;
 
 
+// stream accept followed by a read of its request headers. completes with
+// true if the stream ended with the headers
+struct stream_accept_request_operation : operation<error_code, bool> {
+  stream_impl& stream;
+  h3::fields& fields;
+
+  stream_accept_request_operation(complete_fn complete, stream_impl& stream,
+                                  h3::fields& fields) noexcept
+      : operation(complete), stream(stream), fields(fields)
+  {}
+};
+using stream_accept_request_sync =
+    sync_operation<stream_accept_request_operation>;
+
+template <typename Handler, typename IoExecutor>
+using stream_accept_request_async = async_operation<
+    stream_accept_request_operation, Handler, IoExecutor>;
+
+
 // stream reads and writes
 struct stream_data_operation : operation<error_code, size_t> {
   static constexpr uint16_t max_iovs = 128;
   iovec iovs[max_iovs];
   uint16_t num_iovs = 0;
   size_t bytes_transferred = 0;
+  // write all of the buffers before completing
+  bool write_all = false;
+  // after writing all of the buffers, shut down the sending side
+  bool fin = false;
 
   explicit stream_data_operation(complete_fn complete) noexcept
       : operation(complete) {}
@@ -229,6 +255,97 @@ using stream_data_async = async_operation<
     stream_data_operation, Handler, IoExecutor>;
 
 
+// stream reads that visit lsquic's buffers in place
+struct stream_read_view_operation : operation<error_code, size_t> {
+  /// pass a view of the stream's buffered data to the visitor, and return
+  /// the number of bytes it consumed
+  using visit_fn = size_t (*)(stream_read_view_operation* op,
+                              boost::asio::const_buffer data);
+  visit_fn visit;
+
+  stream_read_view_operation(complete_fn complete, visit_fn visit) noexcept
+      : operation(complete), visit(visit) {}
+};
+
+template <typename Visitor>
+struct stream_read_view_visitor_operation : stream_read_view_operation {
+  Visitor visitor;
+
+  stream_read_view_visitor_operation(complete_fn complete, Visitor&& visitor)
+      : stream_read_view_operation(complete, do_visit),
+        visitor(std::move(visitor))
+  {}
+
+  static size_t do_visit(stream_read_view_operation* op,
+                         boost::asio::const_buffer data) {
+    auto self = static_cast<stream_read_view_visitor_operation*>(op);
+    return self->visitor(data);
+  }
+};
+
+template <typename Visitor>
+using stream_read_view_sync = sync_operation<
+    stream_read_view_visitor_operation<Visitor>>;
+
+template <typename Visitor, typename Handler, typename IoExecutor>
+using stream_read_view_async = async_operation<
+    stream_read_view_visitor_operation<Visitor>, Handler, IoExecutor>;
+
+
+// stream writes that pull from a source
+struct stream_write_source_operation : operation<error_code, size_t> {
+  // the callbacks of lsquic_reader
+  using read_fn = size_t (*)(void* source, void* data, size_t count);
+  using size_fn = size_t (*)(void* source);
+  void* source;
+  read_fn read;
+  size_fn size;
+  // keep writing until the source is empty, instead of completing after the
+  // first bytes are written
+  bool write_all = false;
+  size_t bytes_transferred = 0;
+
+  template <typename Source>
+  stream_write_source_operation(complete_fn complete, Source& source) noexcept
+      : operation(complete), source(&source),
+        read(do_read<Source>), size(do_size<Source>)
+  {}
+
+  template <typename Source>
+  static size_t do_read(void* source, void* data, size_t count) {
+    return static_cast<Source*>(source)->read(data, count);
+  }
+  template <typename Source>
+  static size_t do_size(void* source) {
+    return static_cast<Source*>(source)->size();
+  }
+};
+using stream_write_source_sync = sync_operation<stream_write_source_operation>;
+
+template <typename Handler, typename IoExecutor>
+using stream_write_source_async = async_operation<
+    stream_write_source_operation, Handler, IoExecutor>;
+
+
+// stream writes of a mapped file
+struct stream_send_file_operation : stream_write_source_operation {
+  mapped_file_source file;
+
+  // the base only takes the address of 'file' before it's constructed
+  stream_send_file_operation(complete_fn complete, mapped_file&& f) noexcept
+      : stream_write_source_operation(complete, file),
+        file{std::move(f)}
+  {
+    write_all = true;
+  }
+};
+using stream_send_file_sync = sync_operation<stream_send_file_operation>;
+
+template <typename Handler, typename IoExecutor>
+using stream_send_file_async = async_operation<
+    stream_send_file_operation, Handler, IoExecutor>;
+
+
 // stream header reads
 struct stream_header_read_operation : operation<error_code> {
   h3::fields& fields;
@@ -262,6 +379,27 @@ using stream_header_write_async = async_operation<
     stream_header_write_operation, Handler, IoExecutor>;
 
 
+// stream header writes followed by body data
+struct stream_message_write_operation : stream_data_operation {
+  const h3::header_template* tmpl; // optional fields shared between messages
+  const h3::fields& fields;
+
+  stream_message_write_operation(complete_fn complete,
+                                 const h3::header_template* tmpl,
+                                 const h3::fields& fields) noexcept
+      : stream_data_operation(complete), tmpl(tmpl), fields(fields)
+  {
+    write_all = true;
+  }
+};
+
+using stream_message_write_sync = sync_operation<stream_message_write_operation>;
+
+template <typename Handler, typename IoExecutor>
+using stream_message_write_async = async_operation<
+    stream_message_write_operation, Handler, IoExecutor>;
+
+
 // stream close
 struct stream_close_operation : operation<error_code> {
   explicit stream_close_operation(complete_fn complete) noexcept
@@ -274,4 +412,22 @@ template <typename Handler, typename IoExecutor>
 using stream_close_async = async_operation<
     stream_close_operation, Handler, IoExecutor>;
 
+
+// sharded server accept
+template <typename Connection>
+struct sharded_accept_operation
+    : operation<error_code, std::unique_ptr<Connection>> {
+  using base_type = operation<error_code, std::unique_ptr<Connection>>;
+  explicit sharded_accept_operation(
+      typename base_type::complete_fn complete) noexcept
+      : base_type(complete) {}
+};
+
+template <typename Connection>
+using sharded_accept_sync = sync_operation<sharded_accept_operation<Connection>>;
+
+template <typename Connection, typename Handler, typename IoExecutor>
+using sharded_accept_async = async_operation<
+    sharded_accept_operation<Connection>, Handler, IoExecutor>;
+
 } // namespace nexus::quic::detail
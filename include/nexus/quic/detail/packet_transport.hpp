@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <nexus/error_code.hpp>
+#include <nexus/udp.hpp>
+#include <nexus/quic/socket.hpp>
+
+struct lsquic_out_spec;
+
+namespace nexus::quic::detail {
+
+/// abstract packet i/o for a socket_impl. transports feed received packets
+/// to socket_impl::packet_in() with the engine mutex locked, and send the
+/// packets that lsquic hands to socket_impl::send_packets(). all of these
+/// functions are called with the engine mutex locked
+struct packet_transport {
+  virtual ~packet_transport() {}
+
+  /// return the transport's locally-bound address
+  virtual udp::endpoint local_endpoint() const = 0;
+
+  /// return the optional features that the transport is using
+  virtual socket_features features() const { return {}; }
+
+  /// start delivering received packets to the socket
+  virtual void start_recv() = 0;
+  /// stop delivering received packets to the socket
+  virtual void cancel_recv() = 0;
+
+  /// send packets until the first packet with a different peer_ctx. returns
+  /// the first packet that wasn't sent. if the transport can't take any more
+  /// packets yet, sets ec and errno for lsquic
+  virtual const lsquic_out_spec* send_packets(const lsquic_out_spec* begin,
+                                              const lsquic_out_spec* end,
+                                              error_code& ec) = 0;
+
+  /// stop sending and receiving packets
+  virtual void close() = 0;
+};
+
+using packet_transport_ptr = std::unique_ptr<packet_transport>;
+
+} // namespace nexus::quic::detail
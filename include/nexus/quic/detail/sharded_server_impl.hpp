@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <nexus/ssl.hpp>
+#include <nexus/udp.hpp>
+#include <nexus/quic/error.hpp>
+#include <nexus/quic/settings.hpp>
+#include <nexus/quic/socket.hpp>
+#include <nexus/quic/detail/operation.hpp>
+
+namespace nexus::quic::detail {
+
+/// returns the number of cpus that this process may run on
+unsigned default_shard_count();
+
+/// pin the thread to the i'th cpu that this process may run on, wrapping
+/// around if there are fewer cpus than shards
+void pin_thread(std::thread& thread, unsigned index, error_code& ec);
+
+/// open a UDP socket for the given shard, enable SO_REUSEPORT and bind it to
+/// the endpoint. the first shard's socket also attaches the program that
+/// steers packets to the other sockets in the group by connection id
+udp::socket bind_shard_socket(const boost::asio::any_io_executor& ex,
+                              const udp::endpoint& endpoint,
+                              const settings& s, unsigned index,
+                              unsigned count);
+
+/// runs a Server and Acceptor per shard, each with its own io_context and
+/// thread. each shard accepts connections in a loop and hands them off to a
+/// shared queue, where they're claimed by calls to accept()
+template <typename Server, typename Acceptor, typename Connection>
+class sharded_server_impl {
+  using accept_operation_type = sharded_accept_operation<Connection>;
+
+  struct shard {
+    boost::asio::io_context context{1}; // only run by this shard's thread
+    Server server;
+    Acceptor acceptor;
+    std::unique_ptr<Connection> incoming; // pending acceptor.async_accept()
+    std::thread thread;
+    bool paused = false; // stopped accepting because the queue is full
+
+    shard(const udp::endpoint& endpoint, ssl::context& ssl,
+          const settings& s, unsigned index, unsigned count)
+      : server(context.get_executor(), s),
+        acceptor(server, bind_shard_socket(context.get_executor(),
+                                           endpoint, s, index, count), ssl)
+    {}
+  };
+
+  boost::asio::any_io_executor ex;
+  std::vector<std::unique_ptr<shard>> shards;
+  std::mutex mutex;
+  std::deque<std::unique_ptr<Connection>> accepted;
+  std::deque<accept_operation_type*> waiting;
+  size_t backlog = 0;
+  bool listening = false;
+  bool closed = false;
+
+  void start_accept(shard& sh) {
+    sh.incoming = std::make_unique<Connection>(sh.acceptor);
+    sh.acceptor.async_accept(*sh.incoming, [this, &sh] (error_code ec) {
+          on_accept(sh, ec);
+        });
+  }
+
+  // called on the shard's thread
+  void on_accept(shard& sh, error_code ec) {
+    if (ec == connection_error::aborted ||
+        ec == boost::asio::error::operation_aborted) {
+      sh.incoming.reset();
+      return; // acceptor was closed
+    }
+    auto lock = std::unique_lock{mutex};
+    if (closed) {
+      return;
+    }
+    if (ec) {
+      // this connection failed, but the acceptor is still open. keep
+      // accepting others rather than leave the shard idle
+      lock.unlock();
+      start_accept(sh);
+      return;
+    }
+    if (!waiting.empty()) {
+      auto op = waiting.front();
+      waiting.pop_front();
+      op->post(error_code{}, std::move(sh.incoming));
+    } else {
+      accepted.push_back(std::move(sh.incoming));
+      if (accepted.size() >= backlog) {
+        // leave further connections in the acceptor's own backlog until
+        // accept() makes room
+        sh.paused = true;
+        return;
+      }
+    }
+    lock.unlock();
+    start_accept(sh);
+  }
+
+ public:
+  using executor_type = boost::asio::any_io_executor;
+
+  sharded_server_impl(const executor_type& ex, udp::endpoint endpoint,
+                      ssl::context& ssl, const settings& s,
+                      unsigned num_shards)
+    : ex(ex)
+  {
+    if (num_shards == 0) {
+      num_shards = default_shard_count();
+    }
+    if (num_shards > 256) { // the shard index is a single byte
+      throw system_error(make_error_code(errc::invalid_argument));
+    }
+    if (s.single_threaded) {
+      // the caller's thread uses accepted connections while the shard's
+      // thread processes their engine, so the engine has to lock
+      throw bad_setting("single_threaded can't be used by a sharded server");
+    }
+    shards.reserve(num_shards);
+    for (unsigned i = 0; i < num_shards; i++) {
+      auto config = s;
+      config.reuse_port = true;
+      config.generate_connection_id = sharded_connection_id_generator(i);
+      auto& sh = *shards.emplace_back(
+          std::make_unique<shard>(endpoint, ssl, config, i, num_shards));
+      // bind the remaining shards to the port chosen by the first
+      endpoint = sh.acceptor.local_endpoint();
+    }
+  }
+
+  ~sharded_server_impl() {
+    close();
+  }
+
+  executor_type get_executor() const { return ex; }
+
+  unsigned size() const { return shards.size(); }
+
+  udp::endpoint local_endpoint() const {
+    return shards.front()->acceptor.local_endpoint();
+  }
+
+  void listen(int backlog) {
+    {
+      auto lock = std::scoped_lock{mutex};
+      if (closed) {
+        throw system_error(make_error_code(errc::bad_file_descriptor));
+      }
+      if (listening) { // the shards' threads are already running
+        throw system_error(make_error_code(errc::invalid_argument));
+      }
+      listening = true;
+      this->backlog = std::max(backlog, 1);
+    }
+    for (unsigned i = 0; i < shards.size(); i++) {
+      auto& sh = *shards[i];
+      sh.acceptor.listen(backlog);
+      start_accept(sh);
+      sh.thread = std::thread([&sh] { sh.context.run(); });
+      error_code ec;
+      pin_thread(sh.thread, i, ec); // best effort
+    }
+  }
+
+  void accept(accept_operation_type& op) {
+    auto lock = std::unique_lock{mutex};
+    if (closed) {
+      op.post(make_error_code(connection_error::aborted), nullptr);
+      return;
+    }
+    if (accepted.empty()) {
+      waiting.push_back(&op);
+      return;
+    }
+    auto conn = std::move(accepted.front());
+    accepted.pop_front();
+    op.post(error_code{}, std::move(conn));
+    // resume the shards that stopped when the queue filled up
+    for (auto& sh : shards) {
+      if (sh->paused) {
+        sh->paused = false;
+        boost::asio::post(sh->context, [this, s = sh.get()] {
+              start_accept(*s);
+            });
+      }
+    }
+  }
+
+  template <typename CompletionToken>
+  decltype(auto) async_accept(CompletionToken&& token) {
+    using Signature = void(error_code, std::unique_ptr<Connection>);
+    return boost::asio::async_initiate<CompletionToken, Signature>(
+        [this] (auto h) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = sharded_accept_async<Connection, Handler,
+                                               executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor());
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          accept(*op);
+          op.release(); // release ownership
+        }, token);
+  }
+
+  /// fail pending accepts, then close each shard and join its thread. must
+  /// not be called from a shard's thread
+  void close() {
+    {
+      auto lock = std::scoped_lock{mutex};
+      if (closed) {
+        return;
+      }
+      closed = true;
+      for (auto op : waiting) {
+        op->post(make_error_code(connection_error::aborted), nullptr);
+      }
+      waiting.clear();
+    }
+    accepted.clear();
+    for (auto& sh : shards) {
+      sh->acceptor.close();
+      sh->server.close();
+      // connections that are still open keep the engine's timer running
+      sh->context.stop();
+    }
+    for (auto& sh : shards) {
+      if (sh->thread.joinable()) {
+        sh->thread.join();
+      }
+    }
+  }
+};
+
+} // namespace nexus::quic::detail
@@ -3,22 +3,27 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/circular_buffer.hpp>
 #include <nexus/ssl.hpp>
+#include <nexus/quic/socket.hpp>
 #include <nexus/quic/detail/connection_impl.hpp>
+#include <nexus/quic/detail/packet_transport.hpp>
 
 struct lsquic_conn;
 struct lsquic_out_spec;
 
-namespace nexus::quic::detail {
+namespace nexus::quic {
+
+class memory_network;
+
+namespace detail {
 
 struct engine_impl;
 struct connection_impl;
 
-union sockaddr_union {
-  sockaddr_storage storage;
-  sockaddr addr;
-  sockaddr_in addr4;
-  sockaddr_in6 addr6;
-};
+/// size of the buffers that receive individual packets, which is also the
+/// max_udp_payload_size we advertise to peers
+constexpr size_t max_packet_size = 4096;
+/// size of the buffers that receive coalesced packets with UDP_GRO
+constexpr size_t max_gro_packet_size = 65527;
 
 using connection_list = boost::intrusive::list<connection_impl>;
 
@@ -36,18 +41,22 @@ inline void list_transfer(connection_impl& s, connection_list& from,
 
 struct socket_impl : boost::intrusive::list_base_hook<> {
   engine_impl& engine;
-  udp::socket socket;
   ssl::context& ssl;
-  udp::endpoint local_addr; // socket's bound address
+  packet_transport_ptr transport;
+  udp::endpoint local_addr; // transport's bound address
   boost::circular_buffer<incoming_connection> incoming_connections;
   connection_list accepting_connections;
   connection_list open_connections;
+  socket_stats stats;
   bool receiving = false;
 
   socket_impl(engine_impl& engine, udp::socket&& socket,
-              ssl::context& ssl);
+              ssl::context& ssl, packet_io io = packet_io::reactor);
   socket_impl(engine_impl& engine, const udp::endpoint& endpoint,
-              bool is_server, ssl::context& ssl);
+              bool is_server, ssl::context& ssl,
+              packet_io io = packet_io::reactor);
+  socket_impl(engine_impl& engine, memory_network& network,
+              const udp::endpoint& endpoint, ssl::context& ssl);
   ~socket_impl() {
     close();
   }
@@ -57,6 +66,9 @@ struct socket_impl : boost::intrusive::list_base_hook<> {
 
   udp::endpoint local_endpoint() const { return local_addr; }
 
+  socket_stats get_stats() const;
+  socket_features get_features() const;
+
   void listen(int backlog);
 
   void connect(connection_impl& c,
@@ -87,15 +99,16 @@ struct socket_impl : boost::intrusive::list_base_hook<> {
   void abort_connections(error_code ec);
 
   void start_recv();
-  void on_readable();
-  void on_writeable();
+  void cancel_recv();
+
+  // called by the transport for each received packet
+  void packet_in(const unsigned char* data, size_t length,
+                 const sockaddr* self, const sockaddr* peer, int ecn);
 
   const lsquic_out_spec* send_packets(const lsquic_out_spec* begin,
                                       const lsquic_out_spec* end,
                                       error_code& ec);
-
-  size_t recv_packet(iovec iov, udp::endpoint& peer, sockaddr_union& self,
-                     int& ecn, error_code& ec);
 };
 
-} // namespace nexus::quic::detail
+} // namespace detail
+} // namespace nexus::quic
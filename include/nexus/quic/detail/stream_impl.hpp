@@ -94,6 +94,34 @@ struct stream_impl : public boost::intrusive::list_base_hook<>,
     return std::get<1>(*op.result);
   }
 
+  void read_some_view(stream_read_view_operation& op);
+
+  template <typename Visitor, typename CompletionToken>
+  decltype(auto) async_read_some_view(Visitor&& visitor,
+                                      CompletionToken&& token) {
+    using V = std::decay_t<Visitor>;
+    return boost::asio::async_initiate<CompletionToken, void(error_code, size_t)>(
+        [this] (auto h, V visitor) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_read_view_async<V, Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor(),
+                                             std::move(visitor));
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          read_some_view(*op);
+          op.release(); // release ownership
+        }, token, V{std::forward<Visitor>(visitor)});
+  }
+
+  template <typename Visitor>
+  size_t read_some_view(Visitor&& visitor, error_code& ec) {
+    using V = std::decay_t<Visitor>;
+    stream_read_view_sync<V> op{V{std::forward<Visitor>(visitor)}};
+    read_some_view(op);
+    op.wait();
+    ec = std::get<0>(*op.result);
+    return std::get<1>(*op.result);
+  }
+
   void write_headers(stream_header_write_operation& op);
 
   template <typename CompletionToken>
@@ -111,6 +139,41 @@ struct stream_impl : public boost::intrusive::list_base_hook<>,
         }, token);
   }
 
+  void write_message(stream_message_write_operation& op);
+
+  template <typename ConstBufferSequence, typename CompletionToken>
+  decltype(auto) async_write_message(const h3::header_template* tmpl,
+                                     const h3::fields& fields,
+                                     const ConstBufferSequence& buffers,
+                                     bool fin, CompletionToken&& token) {
+    return boost::asio::async_initiate<CompletionToken, void(error_code, size_t)>(
+        [this, tmpl, &fields, &buffers, fin] (auto h) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_message_write_async<Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h),
+                                             get_executor(), tmpl, fields);
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          init_op(buffers, *op);
+          op->fin = fin;
+          write_message(*op);
+          op.release(); // release ownership
+        }, token);
+  }
+
+  template <typename ConstBufferSequence>
+  size_t write_message(const h3::header_template* tmpl,
+                       const h3::fields& fields,
+                       const ConstBufferSequence& buffers,
+                       bool fin, error_code& ec) {
+    stream_message_write_sync op{tmpl, fields};
+    init_op(buffers, op);
+    op.fin = fin;
+    write_message(op);
+    op.wait();
+    ec = std::get<0>(*op.result);
+    return std::get<1>(*op.result);
+  }
+
   void write_some(stream_data_operation& op);
   void on_write();
 
@@ -141,6 +204,91 @@ struct stream_impl : public boost::intrusive::list_base_hook<>,
     return std::get<1>(*op.result);
   }
 
+  template <typename ConstBufferSequence, typename CompletionToken>
+  decltype(auto) async_write_last(const ConstBufferSequence& buffers,
+                                  CompletionToken&& token) {
+    return boost::asio::async_initiate<CompletionToken, void(error_code, size_t)>(
+        [this, &buffers] (auto h) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_data_async<Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor());
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          init_op(buffers, *op);
+          op->write_all = true;
+          op->fin = true;
+          write_some(*op);
+          op.release(); // release ownership
+        }, token);
+  }
+
+  template <typename ConstBufferSequence>
+  size_t write_last(const ConstBufferSequence& buffers, error_code& ec) {
+    stream_data_sync op;
+    init_op(buffers, op);
+    op.write_all = true;
+    op.fin = true;
+    write_some(op);
+    op.wait();
+    ec = std::get<0>(*op.result);
+    return std::get<1>(*op.result);
+  }
+
+  void write_some_from(stream_write_source_operation& op);
+
+  template <typename Source, typename CompletionToken>
+  decltype(auto) async_write_some_from(Source& source,
+                                       CompletionToken&& token) {
+    return boost::asio::async_initiate<CompletionToken, void(error_code, size_t)>(
+        [this, &source] (auto h) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_write_source_async<Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor(),
+                                             source);
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          write_some_from(*op);
+          op.release(); // release ownership
+        }, token);
+  }
+
+  template <typename Source>
+  size_t write_some_from(Source& source, error_code& ec) {
+    stream_write_source_sync op{source};
+    write_some_from(op);
+    op.wait();
+    ec = std::get<0>(*op.result);
+    return std::get<1>(*op.result);
+  }
+
+  template <typename CompletionToken>
+  decltype(auto) async_send_file(mapped_file&& file, error_code ec,
+                                 CompletionToken&& token) {
+    return boost::asio::async_initiate<CompletionToken, void(error_code, size_t)>(
+        [this] (auto h, mapped_file file, error_code ec) {
+          using Handler = std::decay_t<decltype(h)>;
+          using op_type = stream_send_file_async<Handler, executor_type>;
+          auto p = handler_allocate<op_type>(h, std::move(h), get_executor(),
+                                             std::move(file));
+          auto op = handler_ptr<op_type, Handler>{p, &p->handler};
+          if (ec) { // failed to map the file
+            op->post(ec, 0);
+          } else {
+            write_some_from(*op);
+          }
+          op.release(); // release ownership
+        }, token, std::move(file), ec);
+  }
+
+  size_t send_file(mapped_file&& file, error_code& ec) {
+    if (ec) {
+      return 0;
+    }
+    stream_send_file_sync op{std::move(file)};
+    write_some_from(op);
+    op.wait();
+    ec = std::get<0>(*op.result);
+    return std::get<1>(*op.result);
+  }
+
   void flush(error_code& ec);
   void shutdown(int how, error_code& ec);
 
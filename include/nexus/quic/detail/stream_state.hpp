@@ -13,8 +13,12 @@ struct stream_impl;
 
 struct stream_header_read_operation;
 struct stream_header_write_operation;
+struct stream_message_write_operation;
 struct stream_data_operation;
+struct stream_read_view_operation;
+struct stream_write_source_operation;
 struct stream_accept_operation;
+struct stream_accept_request_operation;
 struct stream_connect_operation;
 struct stream_close_operation;
 
@@ -23,27 +27,42 @@ struct stream_close_operation;
 namespace sending_stream_state {
 
 using header_operation = stream_header_write_operation;
+using message_operation = stream_message_write_operation;
 using data_operation = stream_data_operation;
+using source_operation = stream_write_source_operation;
 
 struct expecting_header {};
 struct header {
   header_operation* op = nullptr;
 };
+struct message {
+  message_operation* op = nullptr;
+};
 struct expecting_body {};
 struct body {
   data_operation* op = nullptr;
 };
+struct body_source {
+  source_operation* op = nullptr;
+};
 struct shutdown {};
 
-using variant = std::variant<expecting_header, header,
-                             expecting_body, body,
+using variant = std::variant<expecting_header, header, message,
+                             expecting_body, body, body_source,
                              shutdown>;
 
 // sending stream events
 void write_header(variant& state, lsquic_stream* handle, header_operation& op);
+void write_message(variant& state, lsquic_stream* handle,
+                   message_operation& op);
 void write_body(variant& state, lsquic_stream* handle, data_operation& op);
+void write_body_source(variant& state, lsquic_stream* handle,
+                       source_operation& op);
 void on_write_header(variant& state, lsquic_stream* handle);
+void on_write_message(variant& state, lsquic_stream* handle);
 void on_write_body(variant& state, lsquic_stream* handle);
+void on_write_body_source(variant& state, lsquic_stream* handle);
+bool wants_write(const variant& state);
 void on_write(variant& state, lsquic_stream* handle);
 int cancel(variant& state, error_code ec);
 void destroy(variant& state);
@@ -55,27 +74,49 @@ void destroy(variant& state);
 namespace receiving_stream_state {
 
 using header_operation = stream_header_read_operation;
+using request_operation = stream_accept_request_operation;
 using data_operation = stream_data_operation;
+using view_operation = stream_read_view_operation;
 
 struct expecting_header {};
 struct header {
   header_operation* op = nullptr;
 };
+struct request {
+  request_operation* op = nullptr;
+};
 struct expecting_body {};
 struct body {
   data_operation* op = nullptr;
 };
+struct body_view {
+  view_operation* op = nullptr;
+};
 struct shutdown {};
 
-using variant = std::variant<expecting_header, header,
-                             expecting_body, body,
+using variant = std::variant<expecting_header, header, request,
+                             expecting_body, body, body_view,
                              shutdown>;
 
+/// the result of starting a body read
+enum class read_status {
+  completed, ///< completed without consuming stream data
+  consumed, ///< completed with data that was already buffered
+  waiting, ///< waiting for on_read()
+};
+
 // receiving stream events
 void read_header(variant& state, lsquic_stream* handle, header_operation* op);
-void read_body(variant& state, lsquic_stream* handle, data_operation* op);
+void read_request(variant& state, lsquic_stream* handle,
+                  request_operation& op);
+read_status read_body(variant& state, lsquic_stream* handle,
+                      data_operation& op);
+read_status read_body_view(variant& state, lsquic_stream* handle,
+                           view_operation& op);
 void on_read_header(variant& state, error_code ec);
+void on_read_request(variant& state, lsquic_stream* handle);
 void on_read_body(variant& state, error_code ec);
+void on_read_body_view(variant& state, lsquic_stream* handle);
 void on_read(variant& state, lsquic_stream* handle);
 int cancel(variant& state, error_code ec);
 void destroy(variant& state);
@@ -91,6 +132,12 @@ struct accepting {
   stream_accept_operation* op = nullptr;
 };
 
+/// like accepting, but the application also wants to read the stream's
+/// request headers once it's accepted
+struct accepting_request {
+  stream_accept_request_operation* op = nullptr;
+};
+
 /// the application has requested to connect() a new outgoing stream, but the
 /// library has not yet opened one
 struct connecting {
@@ -134,7 +181,7 @@ struct error {
 struct closed {
 };
 
-using variant = std::variant<accepting, connecting, open,
+using variant = std::variant<accepting, accepting_request, connecting, open,
                              closing, error, closed>;
 
 /// stream state transitions (only those relevent to close)
@@ -158,14 +205,20 @@ void connect(variant& state, stream_connect_operation& op);
 void on_connect(variant& state, lsquic_stream* handle, bool is_http);
 
 void accept(variant& state, stream_accept_operation& op);
+void accept_request(variant& state, stream_accept_request_operation& op);
 void on_accept(variant& state, lsquic_stream* handle, bool is_http);
 
-bool read(variant& state, stream_data_operation& op);
+receiving_stream_state::read_status read(variant& state,
+                                         stream_data_operation& op);
+receiving_stream_state::read_status read_view(
+    variant& state, stream_read_view_operation& op);
 bool read_headers(variant& state, stream_header_read_operation& op);
 void on_read(variant& state);
 
 bool write(variant& state, stream_data_operation& op);
+bool write_source(variant& state, stream_write_source_operation& op);
 bool write_headers(variant& state, stream_header_write_operation& op);
+bool write_message(variant& state, stream_message_write_operation& op);
 void on_write(variant& state);
 
 void flush(variant& state, error_code& ec);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+
+namespace nexus::quic {
+
+namespace detail {
+struct memory_network_impl;
+struct socket_impl;
+} // namespace detail
+
+/// an in-process network that connects clients and acceptors without kernel
+/// sockets, for benchmarks and deterministic tests. each client or acceptor
+/// binds a udp::endpoint on the network, and packets sent to that endpoint
+/// are copied and delivered on its executor
+class memory_network {
+  friend struct detail::socket_impl;
+  std::shared_ptr<detail::memory_network_impl> impl;
+ public:
+  memory_network();
+};
+
+} // namespace nexus::quic
@@ -2,6 +2,7 @@
 
 #include <nexus/udp.hpp>
 #include <nexus/ssl.hpp>
+#include <nexus/quic/memory_network.hpp>
 #include <nexus/quic/detail/engine_impl.hpp>
 #include <nexus/quic/detail/socket_impl.hpp>
 
@@ -44,10 +45,17 @@ class acceptor {
   using executor_type = detail::socket_impl::executor_type;
 
   /// construct the acceptor, taking ownership of a bound UDP socket
-  acceptor(server& s, udp::socket&& socket, ssl::context& ctx);
+  acceptor(server& s, udp::socket&& socket, ssl::context& ctx,
+           packet_io io = packet_io::reactor);
 
   /// construct the acceptor and bind a UDP socket to the given endpoint
-  acceptor(server& s, const udp::endpoint& endpoint, ssl::context& ctx);
+  acceptor(server& s, const udp::endpoint& endpoint, ssl::context& ctx,
+           packet_io io = packet_io::reactor);
+
+  /// construct the acceptor and bind it to the given endpoint of an
+  /// in-memory network
+  acceptor(server& s, memory_network& network,
+           const udp::endpoint& endpoint, ssl::context& ctx);
 
   /// return the associated io executor
   executor_type get_executor() const;
@@ -55,6 +63,12 @@ class acceptor {
   /// return the socket's locally-bound address/port
   udp::endpoint local_endpoint() const;
 
+  /// return the socket's packet counters
+  socket_stats stats() const;
+
+  /// return the optional packet i/o features in use by the socket
+  socket_features features() const;
+
   /// start receiving packets on the socket. incoming connections can be
   /// accepted with accept()/async_accept(). if the queue of unaccepted
   /// connections reaches 'backlog' in size, new connections are rejected
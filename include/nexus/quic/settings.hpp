@@ -1,7 +1,9 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <stdexcept>
+#include <string>
 
 struct lsquic_engine_settings;
 
@@ -12,6 +14,10 @@ struct bad_setting : std::runtime_error {
   using runtime_error::runtime_error;
 };
 
+/// a function that fills in the bytes of a new connection id
+using connection_id_generator =
+    std::function<void(unsigned char* data, size_t length)>;
+
 /// quic transport settings used to initialize a client or server
 struct settings {
   /// handshake timeout, resulting in connection_error::timed_out
@@ -31,6 +37,55 @@ struct settings {
 
   /// amount of unread bytes a peer is allowed to send on streams we initiate
   uint32_t outgoing_stream_flow_control_window;
+
+  /// maximum time spent in a single pass over the connections that are
+  /// ready to process. the remaining connections are processed on the next
+  /// pass. zero means no limit
+  std::chrono::microseconds processing_time_threshold;
+
+  /// call a stream's read and write handlers at most once per processing
+  /// pass, instead of until they stop making progress
+  bool read_write_once;
+
+  /// maximum number of packets to receive from a socket with a single
+  /// recvmmsg() system call
+  uint16_t receive_batch_size = 32;
+
+  /// maximum number of packets to read from a socket each time it becomes
+  /// readable. a socket that reaches this budget yields to the other sockets
+  /// and handlers on its executor, then continues reading on the next turn
+  uint32_t receive_budget = 256;
+
+  /// send consecutive packets of the same size to the same peer as a single
+  /// buffer with UDP generic segmentation offload (GSO), if the kernel
+  /// supports it
+  bool generic_segmentation_offload = false;
+
+  /// receive coalesced packets from the same peer as a single buffer with
+  /// UDP generic receive offload (GRO), if the kernel supports it
+  bool generic_receive_offload = false;
+
+  /// bind sockets with SO_REUSEPORT, so that several servers can accept
+  /// connections on the same port
+  bool reuse_port = false;
+
+  /// instead of processing connections after every stream and connection
+  /// operation, mark the engine dirty and process once on the next turn of
+  /// the event loop. this coalesces the work of many operations into a single
+  /// pass, which packs their frames into fewer packets
+  bool deferred_processing = false;
+
+  /// skip the locking of the engine's mutex. the application guarantees
+  /// that the client or server, and every acceptor, connection and stream
+  /// associated with it, are only accessed from the single thread that runs
+  /// their executor. the blocking (synchronous) functions can't be used in
+  /// this mode, because they wait on another thread to make progress.
+  /// sharded servers reject this setting
+  bool single_threaded = false;
+
+  /// generates the connection ids that we issue to peers. if empty, lsquic
+  /// generates random ids
+  connection_id_generator generate_connection_id;
 };
 
 /// return default client settings
@@ -53,6 +108,9 @@ namespace detail {
 void read_settings(settings& out, const lsquic_engine_settings& in);
 void write_settings(const settings& in, lsquic_engine_settings& out);
 
+// check the settings that aren't handled by lsquic_engine_check_settings()
+bool check_settings(const settings& s, std::string* message);
+
 } // namespace detail
 
 } // namespace nexus::quic
@@ -2,10 +2,74 @@
 
 #include <nexus/error_code.hpp>
 #include <nexus/udp.hpp>
+#include <nexus/quic/settings.hpp>
 
 namespace nexus::quic {
 
+/// packet counters for the UDP socket of a client or acceptor
+struct socket_stats {
+  /// number of system calls that returned received packets
+  uint64_t receive_calls = 0;
+  /// total number of packets received
+  uint64_t packets_received = 0;
+  /// number of system calls that sent packets
+  uint64_t send_calls = 0;
+  /// total number of packets sent
+  uint64_t packets_sent = 0;
+  /// number of packet trains sent as a single buffer with UDP_SEGMENT
+  uint64_t segmented_sends = 0;
+  /// number of buffers received with several packets coalesced by UDP_GRO
+  uint64_t coalesced_receives = 0;
+  /// number of times receiving stopped at receive_budget to let other
+  /// handlers run, while more packets may have been waiting
+  uint64_t receive_yields = 0;
+};
+
+/// optional packet i/o features in use by the socket of a client or
+/// acceptor. each depends on its setting or packet_io, and on support from
+/// the kernel
+struct socket_features {
+  /// packet trains are sent as a single buffer with UDP_SEGMENT
+  bool generic_segmentation_offload = false;
+  /// several packets may be received in a single buffer with UDP_GRO
+  bool generic_receive_offload = false;
+  /// packets are received with io_uring instead of the reactor. this is
+  /// only reported once the first packet was received that way
+  bool io_uring = false;
+};
+
+/// how the UDP socket of a client or acceptor receives packets, chosen when
+/// it's constructed. packets are always sent with sendmmsg()
+enum class packet_io {
+  /// wait for the socket with the executor's reactor, then read it with
+  /// recvmmsg()
+  reactor,
+  /// receive with a multishot recvmsg on an io_uring, if the library was
+  /// built with liburing and the kernel supports it. otherwise falls back to
+  /// the reactor
+  io_uring,
+};
+
 // enable the socket options necessary for a quic client or server
 void prepare_socket(udp::socket& sock, bool is_server, error_code& ec);
 
+// enable the socket options necessary for a quic client or server, along
+// with any optional socket features enabled by the given settings
+void prepare_socket(udp::socket& sock, bool is_server,
+                    const settings& s, error_code& ec);
+
+// steer packets between the sockets of a SO_REUSEPORT group, so that each
+// connection's packets go to the server that accepted it. the program reads
+// the shard index from the first byte of a short-header packet's destination
+// connection id, and picks the socket at that index in the group. sockets are
+// indexed in the order they were bound, so the server with shard index i must
+// use the i'th socket and sharded_connection_id_generator(i). long-header
+// packets are spread by the kernel's default hash of the address 4-tuple
+void attach_reuseport_cbpf(udp::socket& sock, unsigned num_shards,
+                           error_code& ec);
+
+// returns a generator for settings::generate_connection_id that issues
+// random connection ids with the given shard index in their first byte
+connection_id_generator sharded_connection_id_generator(uint8_t shard);
+
 } // namespace nexus::quic
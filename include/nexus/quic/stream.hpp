@@ -75,6 +75,40 @@ class stream {
     return bytes;
   }
 
+  /// read some bytes without copying them out of the stream's receive
+  /// buffers. the visitor is called with views of contiguous buffered data,
+  /// as size_t(boost::asio::const_buffer data), and returns the number of
+  /// bytes it consumed. a return value less than data.size() stops the read.
+  /// the operation completes with the total number of bytes consumed, which
+  /// may be 0 if the visitor consumed nothing, or with stream_error::eof at
+  /// the end of the stream. the visitor is called with the connection's
+  /// engine locked, so it must not throw or call back into the library, and
+  /// the views are only valid for the duration of each call
+  template <typename Visitor,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_read_some_view(Visitor&& visitor,
+                                      CompletionToken&& token) {
+    return impl.async_read_some_view(std::forward<Visitor>(visitor),
+                                     std::forward<CompletionToken>(token));
+  }
+
+  /// read some bytes without copying them out of the stream's receive
+  /// buffers
+  template <typename Visitor>
+  size_t read_some_view(Visitor&& visitor, error_code& ec) {
+    return impl.read_some_view(std::forward<Visitor>(visitor), ec);
+  }
+  /// \overload
+  template <typename Visitor>
+  size_t read_some_view(Visitor&& visitor) {
+    error_code ec;
+    const size_t bytes = impl.read_some_view(std::forward<Visitor>(visitor), ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
+
   /// write some bytes from the given buffer sequence. written bytes may be
   /// buffered until they fill an outgoing packet
   template <typename ConstBufferSequence,
@@ -101,6 +135,102 @@ class stream {
     return bytes;
   }
 
+  /// write all of the bytes from the given buffer sequence, then shut down
+  /// the stream for writes. the fin is sent along with the final data instead
+  /// of in a separate packet, and the operation completes once all of the
+  /// bytes are written. at most 128 buffers are written from the sequence
+  template <typename ConstBufferSequence,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_write_last(const ConstBufferSequence& buffers,
+                                  CompletionToken&& token) {
+    return impl.async_write_last(buffers, std::forward<CompletionToken>(token));
+  }
+
+  /// write all of the bytes from the given buffer sequence, then shut down
+  /// the stream for writes
+  template <typename ConstBufferSequence>
+  size_t write_last(const ConstBufferSequence& buffers, error_code& ec) {
+    return impl.write_last(buffers, ec);
+  }
+  /// \overload
+  template <typename ConstBufferSequence>
+  size_t write_last(const ConstBufferSequence& buffers) {
+    error_code ec;
+    const size_t bytes = impl.write_last(buffers, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
+
+  /// write some bytes pulled from the given source as outgoing packets are
+  /// built, without staging them in a separate buffer. the Source type
+  /// provides 'size_t size()', returning the number of bytes it has left,
+  /// and 'size_t read(void* data, size_t count)', which copies up to 'count'
+  /// bytes into 'data' and returns the number copied. the stream pulls at
+  /// most what flow control allows, and the operation completes with the
+  /// number of bytes written. the source is called with the connection's
+  /// engine locked, so it must not throw or call back into the library, and
+  /// it must remain valid until the operation completes
+  template <typename Source,
+            typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_write_some_from(Source& source,
+                                       CompletionToken&& token) {
+    return impl.async_write_some_from(source,
+                                      std::forward<CompletionToken>(token));
+  }
+
+  /// write some bytes pulled from the given source
+  template <typename Source>
+  size_t write_some_from(Source& source, error_code& ec) {
+    return impl.write_some_from(source, ec);
+  }
+  /// \overload
+  template <typename Source>
+  size_t write_some_from(Source& source) {
+    error_code ec;
+    const size_t bytes = impl.write_some_from(source, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+    return bytes;
+  }
+
+  /// write a byte range of the open file, such as the range of a Range
+  /// request. the range is memory-mapped and pulled into outgoing packets as
+  /// flow control allows, and the operation completes once the whole range
+  /// is written. the file descriptor can be closed once this returns. the
+  /// file must not be truncated until the operation completes: reading a
+  /// mapped page past the new end of the file raises SIGBUS, from inside the
+  /// connection's processing
+  template <typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_send_file(int fd, uint64_t offset, size_t length,
+                                 CompletionToken&& token) {
+    error_code ec;
+    auto file = detail::mapped_file{fd, offset, length, ec};
+    return impl.async_send_file(std::move(file), ec,
+                                std::forward<CompletionToken>(token));
+  }
+  /// \overload
+  template <typename CompletionToken> // void(error_code, size_t)
+  decltype(auto) async_send_file(const char* path, uint64_t offset,
+                                 size_t length, CompletionToken&& token) {
+    error_code ec;
+    auto file = detail::mapped_file{path, offset, length, ec};
+    return impl.async_send_file(std::move(file), ec,
+                                std::forward<CompletionToken>(token));
+  }
+
+  /// write a byte range of the open file
+  size_t send_file(int fd, uint64_t offset, size_t length, error_code& ec);
+  /// \overload
+  size_t send_file(int fd, uint64_t offset, size_t length);
+  /// write a byte range of the file at the given path
+  size_t send_file(const char* path, uint64_t offset, size_t length,
+                   error_code& ec);
+  /// \overload
+  size_t send_file(const char* path, uint64_t offset, size_t length);
+
   /// flush any bytes that were buffered by write_some()/async_write_some() but
   /// not yet delivered
   void flush(error_code& ec);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/asio/ip/udp.hpp>
+#include <netinet/udp.h>
 
 #include <nexus/error_code.hpp>
 
@@ -42,6 +43,18 @@ class socket_option {
   constexpr void resize(Protocol&, std::size_t) {}
 };
 
+// a boolean socket option at a fixed level, independent of address family
+template <int Level, int Name>
+class fixed_socket_option : public socket_option<Name, Name> {
+ public:
+  using socket_option<Name, Name>::socket_option;
+
+  template <typename Protocol>
+  constexpr int level(const Protocol&) const {
+    return Level;
+  }
+};
+
 template <typename Socket, typename Option>
 error_code set_option(Socket& sock, Option&& option) {
   error_code ec;
@@ -67,4 +80,12 @@ using receive_dstaddr = detail::socket_option<IP_RECVORIGDSTADDR, IPV6_RECVPKTIN
 using receive_dstaddr = detail::socket_option<IP_PKTINFO, IPV6_RECVPKTINFO>;
 #endif
 
+#ifdef UDP_GRO
+using receive_gro = detail::fixed_socket_option<SOL_UDP, UDP_GRO>;
+#endif
+
+#ifdef SO_REUSEPORT
+using reuse_port = detail::fixed_socket_option<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
 } // namespace nexus
@@ -14,9 +14,24 @@ client::client(const executor_type& ex, const udp::endpoint& endpoint,
 }
 
 client::client(const executor_type& ex, const udp::endpoint& endpoint,
-               ssl::context& ctx, const settings& s)
+               ssl::context& ctx, const settings& s, packet_io io)
     : engine(ex, &socket, &s, 0),
-      socket(engine, endpoint, false, ctx)
+      socket(engine, endpoint, false, ctx, io)
+{
+}
+
+client::client(const executor_type& ex, memory_network& network,
+               const udp::endpoint& endpoint, ssl::context& ctx)
+    : engine(ex, &socket, nullptr, 0),
+      socket(engine, network, endpoint, ctx)
+{
+}
+
+client::client(const executor_type& ex, memory_network& network,
+               const udp::endpoint& endpoint, ssl::context& ctx,
+               const settings& s)
+    : engine(ex, &socket, &s, 0),
+      socket(engine, network, endpoint, ctx)
 {
 }
 
@@ -26,9 +41,10 @@ client::client(udp::socket&& socket, ssl::context& ctx)
 {
 }
 
-client::client(udp::socket&& socket, ssl::context& ctx, const settings& s)
+client::client(udp::socket&& socket, ssl::context& ctx, const settings& s,
+               packet_io io)
     : engine(socket.get_executor(), &this->socket, &s, 0),
-      socket(engine, std::move(socket), ctx)
+      socket(engine, std::move(socket), ctx, io)
 {
 }
 
@@ -42,6 +58,16 @@ udp::endpoint client::local_endpoint() const
   return socket.local_endpoint();
 }
 
+socket_stats client::stats() const
+{
+  return socket.get_stats();
+}
+
+socket_features client::features() const
+{
+  return socket.get_features();
+}
+
 void client::connect(connection& conn,
                      const udp::endpoint& endpoint,
                      const char* hostname)
@@ -67,9 +93,25 @@ client::client(const executor_type& ex, const udp::endpoint& endpoint,
 }
 
 client::client(const executor_type& ex, const udp::endpoint& endpoint,
-               ssl::context& ctx, const quic::settings& s)
+               ssl::context& ctx, const quic::settings& s,
+               quic::packet_io io)
     : engine(ex, &socket, &s, LSENG_HTTP),
-      socket(engine, endpoint, false, ctx)
+      socket(engine, endpoint, false, ctx, io)
+{
+}
+
+client::client(const executor_type& ex, quic::memory_network& network,
+               const udp::endpoint& endpoint, ssl::context& ctx)
+    : engine(ex, &socket, nullptr, LSENG_HTTP),
+      socket(engine, network, endpoint, ctx)
+{
+}
+
+client::client(const executor_type& ex, quic::memory_network& network,
+               const udp::endpoint& endpoint, ssl::context& ctx,
+               const quic::settings& s)
+    : engine(ex, &socket, &s, LSENG_HTTP),
+      socket(engine, network, endpoint, ctx)
 {
 }
 
@@ -80,9 +122,9 @@ client::client(udp::socket&& socket, ssl::context& ctx)
 }
 
 client::client(udp::socket&& socket, ssl::context& ctx,
-               const quic::settings& s)
+               const quic::settings& s, quic::packet_io io)
     : engine(socket.get_executor(), &this->socket, &s, LSENG_HTTP),
-      socket(engine, std::move(socket), ctx)
+      socket(engine, std::move(socket), ctx, io)
 {
 }
 
@@ -96,6 +138,16 @@ udp::endpoint client::local_endpoint() const
   return socket.local_endpoint();
 }
 
+quic::socket_stats client::stats() const
+{
+  return socket.get_stats();
+}
+
+quic::socket_features client::features() const
+{
+  return socket.get_features();
+}
+
 void client::connect(client_connection& conn,
                      const udp::endpoint& endpoint,
                      const char* hostname)
@@ -171,7 +171,7 @@ void connection_impl::connect(stream_connect_operation& op)
 {
   auto lock = std::unique_lock{socket.engine.mutex};
   if (connection_state::stream_connect(state, op)) {
-    socket.engine.process(lock);
+    socket.engine.request_process(lock);
   }
 }
 
@@ -186,6 +186,14 @@ void connection_impl::accept(stream_accept_operation& op)
   connection_state::stream_accept(state, op, socket.engine.is_http);
 }
 
+void connection_impl::accept_request(stream_accept_request_operation& op)
+{
+  auto lock = std::unique_lock{socket.engine.mutex};
+  if (connection_state::stream_accept_request(state, op)) {
+    socket.engine.request_process(lock);
+  }
+}
+
 stream_impl* connection_impl::on_accept(lsquic_stream* stream)
 {
   return connection_state::on_stream_accept(state, stream, socket.engine.is_http);
@@ -196,7 +204,7 @@ void connection_impl::go_away(error_code& ec)
   auto lock = std::unique_lock{socket.engine.mutex};
   const auto t = connection_state::goaway(state, ec);
   if (t == connection_state::transition::open_to_going_away) {
-    socket.engine.process(lock);
+    socket.engine.request_process(lock);
   }
 }
 
@@ -211,6 +219,9 @@ void connection_impl::close(error_code& ec)
     case connection_state::transition::open_to_closed:
     case connection_state::transition::going_away_to_closed:
       list_erase(*this, socket.open_connections);
+      // process now even with deferred_processing. this may be called from
+      // the destructor, and lsquic must not call on_conn_closed() later with
+      // a pointer to this connection
       socket.engine.process(lock);
       break;
     default:
@@ -171,6 +171,35 @@ void stream_accept(variant& state, stream_accept_operation& op, bool is_http)
   o.accepting_streams.push_back(op.stream);
 }
 
+bool stream_accept_request(variant& state,
+                           stream_accept_request_operation& op)
+{
+  if (std::holds_alternative<error>(state)) {
+    op.post(std::get_if<error>(&state)->ec, false);
+    state = closed{};
+    return false;
+  } else if (std::holds_alternative<going_away>(state)) {
+    op.post(make_error_code(connection_error::going_away), false);
+    return false;
+  } else if (!std::holds_alternative<open>(state)) {
+    op.post(make_error_code(errc::bad_file_descriptor), false);
+    return false;
+  }
+  auto& o = *std::get_if<open>(&state);
+  stream_state::accept_request(op.stream.state, op);
+  if (!o.incoming_streams.empty()) {
+    auto handle = o.incoming_streams.front();
+    o.incoming_streams.pop_front();
+    stream_state::on_accept(op.stream.state, handle, true);
+    o.open_streams.push_back(op.stream);
+    auto ctx = reinterpret_cast<lsquic_stream_ctx_t*>(&op.stream);
+    ::lsquic_stream_set_ctx(handle, ctx);
+    return true; // process() to read the headers
+  }
+  o.accepting_streams.push_back(op.stream);
+  return false;
+}
+
 stream_impl* on_stream_accept(variant& state, lsquic_stream* handle,
                               bool is_http)
 {
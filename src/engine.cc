@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <lsquic.h>
 #include <lsxpack_header.h>
 
@@ -20,6 +21,35 @@ engine_impl::~engine_impl()
   close();
 }
 
+recv_header_set* engine_impl::acquire_header_set(int is_push_promise)
+{
+  if (free_header_sets.empty()) {
+    return new recv_header_set(*this, is_push_promise);
+  }
+  auto headers = free_header_sets.back().release();
+  free_header_sets.pop_back();
+  headers->is_push_promise = is_push_promise;
+  return headers;
+}
+
+void engine_impl::release_header_set(recv_header_set* headers)
+{
+  auto p = std::unique_ptr<recv_header_set>{headers};
+  if (free_header_sets.size() >= max_free_header_sets) {
+    return;
+  }
+  p->fields.clear();
+  if (p->buffer.capacity() > max_free_header_buffer) {
+    std::vector<char>().swap(p->buffer);
+  }
+  free_header_sets.push_back(std::move(p));
+}
+
+void recv_header_set_deleter::operator()(recv_header_set* headers) const
+{
+  headers->engine.release_header_set(headers);
+}
+
 stream_impl* engine_impl::on_new_stream(connection_impl& c,
                                         lsquic_stream_t* stream)
 {
@@ -40,31 +70,23 @@ void engine_impl::close()
   process(lock);
 }
 
-void engine_impl::process(std::unique_lock<std::mutex>& lock)
+void engine_impl::process(engine_lock& lock)
 {
+  process_pending = false;
   ::lsquic_engine_process_conns(handle.get());
   reschedule(lock);
 }
 
-void engine_impl::reschedule(std::unique_lock<std::mutex>& lock)
+void engine_impl::arm_timer(timer_type::time_point expiry)
 {
-  int micros = 0;
-  if (!::lsquic_engine_earliest_adv_tick(handle.get(), &micros)) {
-    // no connections to process. servers should keep listening for packets,
-    // but clients can stop reading
-    if (client && client->receiving) {
-      client->receiving = false;
-      client->socket.cancel();
-    }
-    timer.cancel();
+  if (timer_armed && timer_expiry <= expiry) {
+    // the pending wait fires early enough. when it does, process() will
+    // reschedule for the tick after that
     return;
   }
-  if (micros <= 0) {
-    process(lock);
-    return;
-  }
-  const auto dur = std::chrono::microseconds{micros};
-  timer.expires_after(dur);
+  timer_armed = true;
+  timer_expiry = expiry;
+  timer.expires_at(expiry); // cancels the pending wait, if any
   timer.async_wait([this] (error_code ec) {
         if (!ec) {
           on_timer();
@@ -72,9 +94,55 @@ void engine_impl::reschedule(std::unique_lock<std::mutex>& lock)
       });
 }
 
+void engine_impl::request_process(engine_lock& lock)
+{
+  if (!config.deferred_processing) {
+    process(lock);
+    return;
+  }
+  if (process_pending) {
+    return;
+  }
+  process_pending = true;
+  // expire the timer immediately. its completion runs on the next turn of
+  // the event loop
+  arm_timer(timer_type::clock_type::now());
+}
+
+// the number of extra passes that reschedule() makes over connections that
+// are already due. past that, it yields to the other handlers on the
+// executor and continues on the next turn of the event loop
+static constexpr int max_due_passes = 4;
+
+void engine_impl::reschedule(engine_lock& lock)
+{
+  int micros = 0;
+  int passes = 0;
+  while (::lsquic_engine_earliest_adv_tick(handle.get(), &micros)) {
+    if (micros > 0 || passes == max_due_passes) {
+      const auto now = timer_type::clock_type::now();
+      arm_timer(now + std::chrono::microseconds{std::max(micros, 0)});
+      return;
+    }
+    // connections are due now
+    ::lsquic_engine_process_conns(handle.get());
+    passes++;
+  }
+  // no connections to process. servers should keep listening for packets,
+  // but clients can stop reading
+  if (client && client->receiving) {
+    client->cancel_recv();
+  }
+  if (timer_armed) {
+    timer_armed = false;
+    timer.cancel();
+  }
+}
+
 void engine_impl::on_timer()
 {
   auto lock = std::unique_lock{mutex};
+  timer_armed = false;
   process(lock);
 }
 
@@ -225,8 +293,8 @@ static constexpr lsquic_stream_if make_stream_api()
 static void* header_set_create(void* ctx, lsquic_stream_t* stream,
                                int is_push_promise)
 {
-  // TODO: store this in stream_impl to avoid allocation?
-  return new recv_header_set(is_push_promise);
+  auto estate = static_cast<engine_impl*>(ctx);
+  return estate->acquire_header_set(is_push_promise);
 }
 
 static lsxpack_header* header_set_prepare(void* hset, lsxpack_header* hdr,
@@ -235,7 +303,9 @@ static lsxpack_header* header_set_prepare(void* hset, lsxpack_header* hdr,
   auto headers = reinterpret_cast<recv_header_set*>(hset);
   auto& header = headers->header;
   auto& buf = headers->buffer;
-  buf.resize(space);
+  if (buf.size() < space) {
+    buf.resize(space);
+  }
   if (hdr) { // existing header, just update the pointer and capacity
     header.buf = buf.data();
     header.val_len = space;
@@ -252,14 +322,19 @@ static int header_set_process(void* hset, lsxpack_header* hdr)
     auto name = std::string_view{hdr->buf + hdr->name_offset, hdr->name_len};
     auto value = std::string_view{hdr->buf + hdr->val_offset, hdr->val_len};
     const bool never_index = hdr->flags & LSXPACK_NEVER_INDEX;
-    auto f = headers->fields.insert(name, value, never_index);
+    // names that reference the QPACK static table are tokenized by index
+    const auto token = (hdr->flags & LSXPACK_QPACK_IDX)
+        ? h3::qpack_static_token(hdr->qpack_index)
+        : h3::lookup_token(name);
+    auto f = headers->fields.insert(name, value, never_index, token);
   }
   return 0;
 }
 
 static void header_set_discard(void* hset)
 {
-  delete reinterpret_cast<recv_header_set*>(hset);
+  auto headers = reinterpret_cast<recv_header_set*>(hset);
+  headers->engine.release_header_set(headers);
 }
 
 static constexpr lsquic_hset_if make_header_api()
@@ -279,6 +354,14 @@ static int api_send_packets(void* ectx, const lsquic_out_spec *specs,
   return estate->send_packets(specs, n_specs);
 }
 
+static void api_generate_scid(void* ectx, lsquic_conn_t* conn,
+                              lsquic_cid_t* cid, unsigned len)
+{
+  auto estate = static_cast<engine_impl*>(ectx);
+  estate->config.generate_connection_id(cid->idbuf, len);
+  cid->len = len;
+}
+
 ssl_ctx_st* api_peer_ssl_ctx(void* peer_ctx, const sockaddr* local)
 {
   auto& socket = *static_cast<socket_impl*>(peer_ctx);
@@ -307,9 +390,20 @@ engine_impl::engine_impl(const boost::asio::any_io_executor& ex,
   lsquic_engine_settings es;
   ::lsquic_engine_init_settings(&es, flags);
   if (s) {
+    std::string message;
+    if (!check_settings(*s, &message)) {
+      throw bad_setting(message);
+    }
     write_settings(*s, es);
+    config = *s;
+  }
+  if (config.single_threaded) {
+    mutex.disable();
   }
   es.es_versions = (1 << LSQVER_I001); // RFC version only
+  // don't let peers send packets larger than our receive buffers
+  es.es_max_udp_payload_size_rx = config.generic_receive_offload ?
+      max_gro_packet_size : max_packet_size;
   char errbuf[256];
   int r = ::lsquic_engine_check_settings(&es, flags, errbuf, sizeof(errbuf));
   if (r == -1) {
@@ -317,6 +411,11 @@ engine_impl::engine_impl(const boost::asio::any_io_executor& ex,
   }
   es.es_delay_onclose = 1;
   api.ea_settings = &es;
+  read_settings(config, es);
+  if (config.generate_connection_id) {
+    api.ea_generate_scid = api_generate_scid;
+    api.ea_gen_scid_ctx = this;
+  }
 
   max_streams_per_connection = es.es_init_max_streams_bidi;
 
@@ -0,0 +1,90 @@
+#include <nexus/quic/detail/mapped_file.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nexus::quic::detail {
+
+mapped_file::mapped_file(int fd, uint64_t offset, size_t length,
+                         error_code& ec)
+{
+  struct stat st;
+  if (::fstat(fd, &st) == -1) {
+    ec.assign(errno, system_category());
+    return;
+  }
+  const uint64_t file_size = st.st_size;
+  if (offset > file_size || length > file_size - offset) {
+    ec = make_error_code(errc::invalid_argument);
+    return;
+  }
+  ec.clear();
+  if (length == 0) {
+    return; // mmap() rejects empty mappings
+  }
+  // mmap() offsets must be page-aligned
+  const uint64_t page_size = ::sysconf(_SC_PAGESIZE);
+  const uint64_t aligned = offset - (offset % page_size);
+  const size_t size = length + (offset - aligned);
+  void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, aligned);
+  if (p == MAP_FAILED) {
+    ec.assign(errno, system_category());
+    return;
+  }
+  // the stream reads the range front to back
+  ::madvise(p, size, MADV_SEQUENTIAL);
+  addr = p;
+  mapped_size = size;
+  begin = static_cast<const unsigned char*>(p) + (offset - aligned);
+  this->length = length;
+}
+
+mapped_file::mapped_file(const char* path, uint64_t offset, size_t length,
+                         error_code& ec)
+{
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    ec.assign(errno, system_category());
+    return;
+  }
+  *this = mapped_file{fd, offset, length, ec};
+  ::close(fd); // the mapping holds its own reference to the file
+}
+
+mapped_file::~mapped_file()
+{
+  if (addr) {
+    ::munmap(addr, mapped_size);
+  }
+}
+
+mapped_file::mapped_file(mapped_file&& o) noexcept
+  : addr(std::exchange(o.addr, nullptr)),
+    mapped_size(std::exchange(o.mapped_size, 0)),
+    begin(std::exchange(o.begin, nullptr)),
+    length(std::exchange(o.length, 0))
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& o) noexcept
+{
+  std::swap(addr, o.addr);
+  std::swap(mapped_size, o.mapped_size);
+  std::swap(begin, o.begin);
+  std::swap(length, o.length);
+  return *this;
+}
+
+size_t mapped_file_source::read(void* data, size_t count)
+{
+  count = std::min(count, size());
+  ::memcpy(data, file.data() + offset, count);
+  offset += count;
+  return count;
+}
+
+} // namespace nexus::quic::detail
@@ -0,0 +1,255 @@
+#include <nexus/quic/memory_network.hpp>
+#include <nexus/quic/detail/engine_impl.hpp>
+#include <nexus/quic/detail/socket_impl.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <lsquic.h>
+
+#include "memory_transport.hpp"
+
+namespace nexus::quic {
+
+namespace detail {
+
+struct memory_transport;
+
+struct datagram {
+  udp::endpoint source;
+  int ecn = 0;
+  std::vector<unsigned char> data;
+};
+
+// the receiving side of a memory_transport, shared with its senders
+struct memory_endpoint {
+  std::mutex mutex;
+  std::condition_variable cond;
+  boost::asio::any_io_executor ex;
+  memory_transport* transport; // null once closed
+  std::vector<datagram> queue;
+  bool scheduled = false; // a call to deliver() is pending
+  bool delivering = false; // the transport is processing packets
+
+  memory_endpoint(const boost::asio::any_io_executor& ex,
+                  memory_transport* transport)
+    : ex(ex), transport(transport) {}
+};
+
+struct memory_network_impl {
+  std::mutex mutex;
+  std::map<udp::endpoint, std::shared_ptr<memory_endpoint>> endpoints;
+  unsigned short next_port = 49152; // start of the dynamic port range
+
+  udp::endpoint bind(udp::endpoint endpoint,
+                     std::shared_ptr<memory_endpoint> ep);
+  void unbind(const udp::endpoint& endpoint,
+              const std::shared_ptr<memory_endpoint>& ep);
+  void send(const udp::endpoint& dest, datagram&& packet);
+};
+
+struct memory_transport : packet_transport {
+  socket_impl& socket;
+  std::shared_ptr<memory_network_impl> network;
+  std::shared_ptr<memory_endpoint> receiver;
+  udp::endpoint local_addr;
+  // outstanding work on the executor while receiving, like a pending
+  // async_wait() on a socket
+  boost::asio::any_io_executor work;
+  bool closed = false;
+
+  memory_transport(socket_impl& socket,
+                   std::shared_ptr<memory_network_impl> network,
+                   const udp::endpoint& endpoint);
+  ~memory_transport();
+
+  udp::endpoint local_endpoint() const override { return local_addr; }
+
+  void start_recv() override;
+  void cancel_recv() override;
+
+  const lsquic_out_spec* send_packets(const lsquic_out_spec* begin,
+                                      const lsquic_out_spec* end,
+                                      error_code& ec) override;
+
+  void close() override;
+
+  void on_packets(std::vector<datagram>& packets);
+};
+
+udp::endpoint memory_network_impl::bind(udp::endpoint endpoint,
+                                        std::shared_ptr<memory_endpoint> ep)
+{
+  auto lock = std::scoped_lock{mutex};
+  if (endpoint.port() == 0) {
+    do {
+      endpoint.port(next_port++);
+      if (next_port == 0) {
+        next_port = 49152;
+      }
+    } while (endpoints.count(endpoint));
+  }
+  auto [i, inserted] = endpoints.emplace(endpoint, std::move(ep));
+  if (!inserted) {
+    throw system_error(make_error_code(errc::address_in_use));
+  }
+  return endpoint;
+}
+
+void memory_network_impl::unbind(const udp::endpoint& endpoint,
+                                 const std::shared_ptr<memory_endpoint>& ep)
+{
+  auto lock = std::scoped_lock{mutex};
+  // the port may have been reused after close()
+  if (auto i = endpoints.find(endpoint);
+      i != endpoints.end() && i->second == ep) {
+    endpoints.erase(i);
+  }
+}
+
+static void deliver(const std::shared_ptr<memory_endpoint>& ep)
+{
+  auto lock = std::unique_lock{ep->mutex};
+  ep->scheduled = false;
+  if (!ep->transport) {
+    return;
+  }
+  auto packets = std::move(ep->queue);
+  ep->queue.clear();
+  // don't hold the endpoint's mutex while the engine processes the packets
+  // and sends more. ~memory_transport() waits for this to finish
+  auto transport = ep->transport;
+  ep->delivering = true;
+  lock.unlock();
+
+  transport->on_packets(packets);
+
+  lock.lock();
+  ep->delivering = false;
+  ep->cond.notify_all();
+}
+
+void memory_network_impl::send(const udp::endpoint& dest, datagram&& packet)
+{
+  auto lock = std::scoped_lock{mutex};
+  auto i = endpoints.find(dest);
+  if (i == endpoints.end()) {
+    // match a socket bound to the unspecified address
+    const auto any = dest.address().is_v6()
+        ? udp::endpoint{udp::v6(), dest.port()}
+        : udp::endpoint{udp::v4(), dest.port()};
+    i = endpoints.find(any);
+    if (i == endpoints.end()) {
+      return; // no one is listening, drop the packet
+    }
+  }
+  auto& ep = i->second;
+  auto eplock = std::scoped_lock{ep->mutex};
+  ep->queue.push_back(std::move(packet));
+  if (!ep->scheduled) {
+    ep->scheduled = true;
+    boost::asio::post(ep->ex, [ep] { deliver(ep); });
+  }
+}
+
+memory_transport::memory_transport(
+    socket_impl& socket, std::shared_ptr<memory_network_impl> network,
+    const udp::endpoint& endpoint)
+  : socket(socket),
+    network(std::move(network)),
+    receiver(std::make_shared<memory_endpoint>(socket.get_executor(), this)),
+    local_addr(this->network->bind(endpoint, receiver))
+{
+}
+
+memory_transport::~memory_transport()
+{
+  network->unbind(local_addr, receiver);
+  auto lock = std::unique_lock{receiver->mutex};
+  receiver->transport = nullptr;
+  receiver->cond.wait(lock, [this] { return !receiver->delivering; });
+}
+
+void memory_transport::start_recv()
+{
+  work = boost::asio::prefer(socket.get_executor(),
+      boost::asio::execution::outstanding_work.tracked);
+}
+
+void memory_transport::cancel_recv()
+{
+  work = boost::asio::any_io_executor{};
+}
+
+void memory_transport::close()
+{
+  closed = true;
+  work = boost::asio::any_io_executor{};
+  network->unbind(local_addr, receiver);
+}
+
+void memory_transport::on_packets(std::vector<datagram>& packets)
+{
+  auto lock = std::unique_lock{socket.engine.mutex};
+  if (closed) {
+    return;
+  }
+  socket.stats.receive_calls++;
+  for (auto& p : packets) {
+    socket.packet_in(p.data.data(), p.data.size(), local_addr.data(),
+                     p.source.data(), p.ecn);
+  }
+  // process the whole batch at once
+  socket.engine.process(lock);
+}
+
+auto memory_transport::send_packets(const lsquic_out_spec* begin,
+                                    const lsquic_out_spec* end,
+                                    error_code& ec)
+  -> const lsquic_out_spec*
+{
+  if (closed) {
+    ec = make_error_code(errc::bad_file_descriptor);
+    errno = ec.value();
+    return begin;
+  }
+  auto p = begin;
+  for (; p < end && p->peer_ctx == begin->peer_ctx; ++p) {
+    datagram packet;
+    packet.source = local_addr;
+    packet.ecn = p->ecn;
+    for (size_t i = 0; i < p->iovlen; i++) {
+      auto data = static_cast<const unsigned char*>(p->iov[i].iov_base);
+      packet.data.insert(packet.data.end(), data, data + p->iov[i].iov_len);
+    }
+    udp::endpoint dest;
+    const size_t size = p->dest_sa->sa_family == AF_INET
+        ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+    ::memcpy(dest.data(), p->dest_sa, size);
+    dest.resize(size);
+    network->send(dest, std::move(packet));
+  }
+  socket.stats.send_calls++;
+  socket.stats.packets_sent += std::distance(begin, p);
+  return p;
+}
+
+packet_transport_ptr make_memory_transport(
+    socket_impl& socket,
+    const std::shared_ptr<memory_network_impl>& network,
+    const udp::endpoint& endpoint)
+{
+  return std::make_unique<memory_transport>(socket, network, endpoint);
+}
+
+} // namespace detail
+
+memory_network::memory_network()
+  : impl(std::make_shared<detail::memory_network_impl>())
+{
+}
+
+} // namespace nexus::quic
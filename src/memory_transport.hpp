@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <nexus/quic/memory_network.hpp>
+#include <nexus/quic/detail/packet_transport.hpp>
+
+namespace nexus::quic::detail {
+
+struct socket_impl;
+
+/// create a transport that binds the given endpoint on a memory_network. if
+/// the endpoint's port is 0, the network assigns an unused one
+packet_transport_ptr make_memory_transport(
+    socket_impl& socket,
+    const std::shared_ptr<memory_network_impl>& network,
+    const udp::endpoint& endpoint);
+
+} // namespace nexus::quic::detail
@@ -1,18 +1,31 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <nexus/h3/fields.hpp>
 #include <lsxpack_header.h>
 
 namespace nexus::quic::detail {
 
+struct engine_impl;
+
 struct recv_header_set {
+  engine_impl& engine; // returned to its engine's free list when released
   h3::fields fields;
   int is_push_promise;
   lsxpack_header header;
-  std::vector<char> buffer;
+  std::vector<char> buffer; // keeps its capacity between uses
+
+  recv_header_set(engine_impl& engine, int is_push_promise)
+      : engine(engine), is_push_promise(is_push_promise) {}
+};
 
-  recv_header_set(int is_push_promise) : is_push_promise(is_push_promise) {}
+struct recv_header_set_deleter {
+  void operator()(recv_header_set* headers) const;
 };
 
+/// owning pointer that releases the header set back to its engine
+using recv_header_set_ptr =
+    std::unique_ptr<recv_header_set, recv_header_set_deleter>;
+
 } // namespace nexus::quic::detail
@@ -25,13 +25,19 @@ void server::close()
   engine.close();
 }
 
-acceptor::acceptor(server& s, udp::socket&& socket, ssl::context& ctx)
-    : impl(s.engine, std::move(socket), ctx)
+acceptor::acceptor(server& s, udp::socket&& socket, ssl::context& ctx,
+                   packet_io io)
+    : impl(s.engine, std::move(socket), ctx, io)
 {}
 
 acceptor::acceptor(server& s, const udp::endpoint& endpoint,
-                   ssl::context& ctx)
-    : impl(s.engine, endpoint, true, ctx)
+                   ssl::context& ctx, packet_io io)
+    : impl(s.engine, endpoint, true, ctx, io)
+{}
+
+acceptor::acceptor(server& s, memory_network& network,
+                   const udp::endpoint& endpoint, ssl::context& ctx)
+    : impl(s.engine, network, endpoint, ctx)
 {}
 
 acceptor::executor_type acceptor::get_executor() const
@@ -44,6 +50,16 @@ udp::endpoint acceptor::local_endpoint() const
   return impl.local_endpoint();
 }
 
+socket_stats acceptor::stats() const
+{
+  return impl.get_stats();
+}
+
+socket_features acceptor::features() const
+{
+  return impl.get_features();
+}
+
 void acceptor::listen(int backlog)
 {
   return impl.listen(backlog);
@@ -88,13 +104,19 @@ server::executor_type server::get_executor() const
   return engine.get_executor();
 }
 
-acceptor::acceptor(server& s, udp::socket&& socket, ssl::context& ctx)
-    : impl(s.engine, std::move(socket), ctx)
+acceptor::acceptor(server& s, udp::socket&& socket, ssl::context& ctx,
+                   quic::packet_io io)
+    : impl(s.engine, std::move(socket), ctx, io)
 {}
 
 acceptor::acceptor(server& s, const udp::endpoint& endpoint,
-                   ssl::context& ctx)
-    : impl(s.engine, endpoint, true, ctx)
+                   ssl::context& ctx, quic::packet_io io)
+    : impl(s.engine, endpoint, true, ctx, io)
+{}
+
+acceptor::acceptor(server& s, quic::memory_network& network,
+                   const udp::endpoint& endpoint, ssl::context& ctx)
+    : impl(s.engine, network, endpoint, ctx)
 {}
 
 acceptor::executor_type acceptor::get_executor() const
@@ -107,6 +129,16 @@ udp::endpoint acceptor::local_endpoint() const
   return impl.local_endpoint();
 }
 
+quic::socket_stats acceptor::stats() const
+{
+  return impl.get_stats();
+}
+
+quic::socket_features acceptor::features() const
+{
+  return impl.get_features();
+}
+
 void acceptor::listen(int backlog)
 {
   return impl.listen(backlog);
@@ -186,6 +218,25 @@ void server_connection::accept(stream& s)
   }
 }
 
+bool server_connection::accept_request(stream& s, fields& f, error_code& ec)
+{
+  auto op = quic::detail::stream_accept_request_sync{s.impl, f};
+  impl.accept_request(op);
+  op.wait();
+  ec = std::get<0>(*op.result);
+  return std::get<1>(*op.result);
+}
+
+bool server_connection::accept_request(stream& s, fields& f)
+{
+  error_code ec;
+  const bool fin = accept_request(s, f, ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  return fin;
+}
+
 void server_connection::go_away(error_code& ec)
 {
   impl.go_away(ec);
@@ -18,6 +18,9 @@ void read_settings(settings& out, const lsquic_engine_settings& in)
       in.es_init_max_stream_data_bidi_remote;
   out.outgoing_stream_flow_control_window =
       in.es_init_max_stream_data_bidi_local;
+  out.processing_time_threshold =
+      std::chrono::microseconds(in.es_proc_time_thresh);
+  out.read_write_once = in.es_rw_once;
 }
 
 void write_settings(const settings& in, lsquic_engine_settings& out)
@@ -33,6 +36,25 @@ void write_settings(const settings& in, lsquic_engine_settings& out)
       in.incoming_stream_flow_control_window;
   out.es_init_max_stream_data_bidi_local =
       in.outgoing_stream_flow_control_window;
+  out.es_proc_time_thresh = in.processing_time_threshold.count();
+  out.es_rw_once = in.read_write_once;
+}
+
+bool check_settings(const settings& s, std::string* message)
+{
+  if (s.receive_batch_size == 0) {
+    if (message) {
+      message->assign("receive_batch_size must be greater than 0");
+    }
+    return false;
+  }
+  if (s.receive_budget == 0) {
+    if (message) {
+      message->assign("receive_budget must be greater than 0");
+    }
+    return false;
+  }
+  return true;
 }
 
 bool check_settings(const lsquic_engine_settings& es, int flags,
@@ -75,7 +97,8 @@ bool check_client_settings(const settings& s, std::string* message)
   lsquic_engine_settings es;
   ::lsquic_engine_init_settings(&es, flags);
   detail::write_settings(s, es);
-  return detail::check_settings(es, flags, message);
+  return detail::check_settings(s, message)
+      && detail::check_settings(es, flags, message);
 }
 
 bool check_server_settings(const settings& s, std::string* message)
@@ -84,7 +107,8 @@ bool check_server_settings(const settings& s, std::string* message)
   lsquic_engine_settings es;
   ::lsquic_engine_init_settings(&es, flags);
   detail::write_settings(s, es);
-  return detail::check_settings(es, flags, message);
+  return detail::check_settings(s, message)
+      && detail::check_settings(es, flags, message);
 }
 
 } // namespace nexus::quic
@@ -0,0 +1,196 @@
+#include <nexus/quic/sharded_server.hpp>
+#include <nexus/h3/sharded_server.hpp>
+#include <pthread.h>
+#include <sched.h>
+
+namespace nexus {
+namespace quic {
+namespace detail {
+
+unsigned default_shard_count()
+{
+  cpu_set_t cpus;
+  if (::sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+    return CPU_COUNT(&cpus);
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void pin_thread(std::thread& thread, unsigned index, error_code& ec)
+{
+  cpu_set_t cpus;
+  if (::sched_getaffinity(0, sizeof(cpus), &cpus) == -1) {
+    ec.assign(errno, system_category());
+    return;
+  }
+  // find the index'th cpu in the process' affinity mask
+  const unsigned count = CPU_COUNT(&cpus);
+  if (count == 0) {
+    ec = make_error_code(errc::invalid_argument);
+    return;
+  }
+  index %= count;
+  int cpu = 0;
+  for (;; cpu++) {
+    if (CPU_ISSET(cpu, &cpus) && index-- == 0) {
+      break;
+    }
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // returns the error instead of setting errno
+  const int r = ::pthread_setaffinity_np(thread.native_handle(),
+                                         sizeof(set), &set);
+  if (r != 0) {
+    ec.assign(r, system_category());
+  } else {
+    ec.clear();
+  }
+}
+
+udp::socket bind_shard_socket(const boost::asio::any_io_executor& ex,
+                              const udp::endpoint& endpoint,
+                              const settings& s, unsigned index,
+                              unsigned count)
+{
+  auto socket = udp::socket{ex, endpoint.protocol()};
+  error_code ec;
+  prepare_socket(socket, true, s, ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  socket.bind(endpoint); // may throw
+  if (index == 0) {
+    // the program belongs to the reuseport group, so it also applies to the
+    // sockets that join later. sockets are indexed in the order they bind
+    attach_reuseport_cbpf(socket, count, ec);
+    if (ec) {
+      throw system_error(ec);
+    }
+  }
+  return socket;
+}
+
+} // namespace detail
+
+sharded_server::sharded_server(const executor_type& ex,
+                               const udp::endpoint& endpoint,
+                               ssl::context& ctx, unsigned num_shards)
+    : impl(ex, endpoint, ctx, default_server_settings(), num_shards)
+{}
+
+sharded_server::sharded_server(const executor_type& ex,
+                               const udp::endpoint& endpoint,
+                               ssl::context& ctx, const settings& s,
+                               unsigned num_shards)
+    : impl(ex, endpoint, ctx, s, num_shards)
+{}
+
+sharded_server::executor_type sharded_server::get_executor() const
+{
+  return impl.get_executor();
+}
+
+unsigned sharded_server::size() const
+{
+  return impl.size();
+}
+
+udp::endpoint sharded_server::local_endpoint() const
+{
+  return impl.local_endpoint();
+}
+
+void sharded_server::listen(int backlog)
+{
+  impl.listen(backlog);
+}
+
+std::unique_ptr<connection> sharded_server::accept(error_code& ec)
+{
+  detail::sharded_accept_sync<connection> op;
+  impl.accept(op);
+  op.wait();
+  ec = std::get<0>(*op.result);
+  return std::move(std::get<1>(*op.result));
+}
+
+std::unique_ptr<connection> sharded_server::accept()
+{
+  error_code ec;
+  auto conn = accept(ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  return conn;
+}
+
+void sharded_server::close()
+{
+  impl.close();
+}
+
+} // namespace quic
+
+namespace h3 {
+
+sharded_server::sharded_server(const executor_type& ex,
+                               const udp::endpoint& endpoint,
+                               ssl::context& ctx, unsigned num_shards)
+    : impl(ex, endpoint, ctx, quic::default_server_settings(), num_shards)
+{}
+
+sharded_server::sharded_server(const executor_type& ex,
+                               const udp::endpoint& endpoint,
+                               ssl::context& ctx, const quic::settings& s,
+                               unsigned num_shards)
+    : impl(ex, endpoint, ctx, s, num_shards)
+{}
+
+sharded_server::executor_type sharded_server::get_executor() const
+{
+  return impl.get_executor();
+}
+
+unsigned sharded_server::size() const
+{
+  return impl.size();
+}
+
+udp::endpoint sharded_server::local_endpoint() const
+{
+  return impl.local_endpoint();
+}
+
+void sharded_server::listen(int backlog)
+{
+  impl.listen(backlog);
+}
+
+std::unique_ptr<server_connection> sharded_server::accept(error_code& ec)
+{
+  quic::detail::sharded_accept_sync<server_connection> op;
+  impl.accept(op);
+  op.wait();
+  ec = std::get<0>(*op.result);
+  return std::move(std::get<1>(*op.result));
+}
+
+std::unique_ptr<server_connection> sharded_server::accept()
+{
+  error_code ec;
+  auto conn = accept(ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  return conn;
+}
+
+void sharded_server::close()
+{
+  impl.close();
+}
+
+} // namespace h3
+} // namespace nexus
@@ -1,59 +1,40 @@
 #include <nexus/quic/socket.hpp>
 #include <nexus/quic/detail/engine_impl.hpp>
 #include <nexus/quic/detail/socket_impl.hpp>
-#include <array>
-#include <cstring>
 
-#include <netinet/ip.h>
 #include <lsquic.h>
 
-namespace nexus::quic {
+#include "memory_transport.hpp"
+#include "udp_transport.hpp"
 
-void prepare_socket(udp::socket& sock, bool is_server, error_code& ec)
-{
-  if (sock.non_blocking(true, ec); ec) {
-    return;
-  }
-  if (sock.set_option(receive_ecn{true}, ec); ec) {
-    return;
-  }
-  if (is_server) {
-    ec = nexus::detail::set_options(sock, receive_dstaddr{true},
-                                    udp::socket::reuse_address{true});
-  }
-}
+namespace nexus::quic::detail {
 
-namespace detail {
-
-static udp::socket bind_socket(const boost::asio::any_io_executor& ex,
-                               const udp::endpoint& endpoint, bool is_server)
+socket_impl::socket_impl(engine_impl& engine, udp::socket&& socket,
+                         ssl::context& ssl, packet_io io)
+    : engine(engine),
+      ssl(ssl),
+      transport(std::make_unique<udp_transport>(*this, std::move(socket),
+                                                io)),
+      local_addr(transport->local_endpoint())
 {
-  // open the socket
-  auto socket = udp::socket{ex, endpoint.protocol()};
-  // set socket options before bind(), because the server enables REUSEADDR
-  error_code ec;
-  prepare_socket(socket, is_server, ec);
-  if (ec) {
-    throw system_error(ec);
-  }
-  socket.bind(endpoint); // may throw
-  return socket;
 }
 
-socket_impl::socket_impl(engine_impl& engine, udp::socket&& socket,
-                         ssl::context& ssl)
+socket_impl::socket_impl(engine_impl& engine, const udp::endpoint& endpoint,
+                         bool is_server, ssl::context& ssl, packet_io io)
     : engine(engine),
-      socket(std::move(socket)),
       ssl(ssl),
-      local_addr(this->socket.local_endpoint())
-{}
+      transport(std::make_unique<udp_transport>(*this, endpoint, is_server,
+                                                io)),
+      local_addr(transport->local_endpoint())
+{
+}
 
-socket_impl::socket_impl(engine_impl& engine, const udp::endpoint& endpoint,
-                         bool is_server, ssl::context& ssl)
+socket_impl::socket_impl(engine_impl& engine, memory_network& network,
+                         const udp::endpoint& endpoint, ssl::context& ssl)
     : engine(engine),
-      socket(bind_socket(engine.get_executor(), endpoint, is_server)),
       ssl(ssl),
-      local_addr(this->socket.local_endpoint())
+      transport(make_memory_transport(*this, network.impl, endpoint)),
+      local_addr(transport->local_endpoint())
 {
 }
 
@@ -62,6 +43,18 @@ socket_impl::executor_type socket_impl::get_executor() const
   return engine.get_executor();
 }
 
+socket_stats socket_impl::get_stats() const
+{
+  auto lock = std::unique_lock{engine.mutex};
+  return stats;
+}
+
+socket_features socket_impl::get_features() const
+{
+  auto lock = std::unique_lock{engine.mutex};
+  return transport->features();
+}
+
 void socket_impl::listen(int backlog)
 {
   auto lock = std::unique_lock{engine.mutex};
@@ -83,7 +76,7 @@ void socket_impl::connect(connection_impl& c,
   // note, this assert triggers with some quic versions that don't allow
   // multiple connections on the same address, see lquic's hash_conns_by_addr()
   assert(connection_state::is_open(c.state));
-  engine.process(lock);
+  engine.request_process(lock);
   start_recv();
 }
 
@@ -110,7 +103,7 @@ void socket_impl::accept(connection_impl& c, accept_operation& op)
   }
   connection_state::accept(c.state, op);
   accepting_connections.push_back(c);
-  engine.process(lock);
+  engine.request_process(lock);
 }
 
 connection_context* socket_impl::on_accept(lsquic_conn_t* conn)
@@ -161,7 +154,7 @@ void socket_impl::close()
   // send any CONNECTION_CLOSE frames before closing the socket
   engine.process(lock);
   receiving = false;
-  socket.close();
+  transport->close();
 }
 
 void socket_impl::start_recv()
@@ -170,49 +163,23 @@ void socket_impl::start_recv()
     return;
   }
   receiving = true;
-  socket.async_wait(udp::socket::wait_read,
-      [this] (error_code ec) {
-        receiving = false;
-        if (!ec) {
-          on_readable();
-        } // XXX: else fatal? retry?
-      });
+  transport->start_recv();
 }
 
-void socket_impl::on_readable()
+void socket_impl::cancel_recv()
 {
-  std::array<unsigned char, 4096> buffer;
-  iovec iov;
-  iov.iov_base = buffer.data();
-  iov.iov_len = buffer.size();
-
-  error_code ec;
-  for (;;) {
-    udp::endpoint peer;
-    sockaddr_union self;
-    int ecn = 0;
-
-    const auto bytes = recv_packet(iov, peer, self, ecn, ec);
-    if (ec) {
-      if (ec == errc::resource_unavailable_try_again ||
-          ec == errc::operation_would_block) {
-        start_recv();
-      } // XXX: else fatal? retry?
-      return;
-    }
-
-    auto lock = std::unique_lock{engine.mutex};
-    const auto peer_ctx = this;
-    ::lsquic_engine_packet_in(engine.handle.get(), buffer.data(), bytes,
-                              &self.addr, peer.data(), peer_ctx, ecn);
-    engine.process(lock);
-  }
+  receiving = false;
+  transport->cancel_recv();
 }
 
-void socket_impl::on_writeable()
+void socket_impl::packet_in(const unsigned char* data, size_t length,
+                            const sockaddr* self, const sockaddr* peer,
+                            int ecn)
 {
-  auto lock = std::scoped_lock{engine.mutex};
-  ::lsquic_engine_send_unsent_packets(engine.handle.get());
+  const auto peer_ctx = this;
+  ::lsquic_engine_packet_in(engine.handle.get(), data, length,
+                            self, peer, peer_ctx, ecn);
+  stats.packets_received++;
 }
 
 auto socket_impl::send_packets(const lsquic_out_spec* begin,
@@ -220,130 +187,7 @@ auto socket_impl::send_packets(const lsquic_out_spec* begin,
                                error_code& ec)
   -> const lsquic_out_spec*
 {
-  msghdr msg;
-  msg.msg_flags = 0;
-
-  // send until we encounter a packet with a different peer_ctx
-  auto p = begin;
-  for (; p < end && p->peer_ctx == begin->peer_ctx; ++p) {
-    msg.msg_name = const_cast<void*>(static_cast<const void*>(p->dest_sa));
-    if (p->dest_sa->sa_family == AF_INET) {
-      msg.msg_namelen = sizeof(struct sockaddr_in);
-    } else {
-      msg.msg_namelen = sizeof(struct sockaddr_in6);
-    }
-
-    msg.msg_iov = p->iov;
-    msg.msg_iovlen = p->iovlen;
-
-    constexpr size_t ecn_size = sizeof(int); // TODO: add DSTADDR
-    constexpr size_t max_control_size = CMSG_SPACE(ecn_size);
-    auto control = std::array<unsigned char, max_control_size>{};
-    if (p->ecn) {
-      msg.msg_control = control.data();
-      msg.msg_controllen = control.size();
-
-      cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
-      if (p->dest_sa->sa_family == AF_INET) {
-        cmsg->cmsg_level = IPPROTO_IP;
-        cmsg->cmsg_type = IP_PKTINFO;
-      } else {
-        cmsg->cmsg_level = IPPROTO_IPV6;
-        cmsg->cmsg_type = IPV6_TCLASS;
-      }
-      cmsg->cmsg_len = CMSG_LEN(ecn_size);
-      ::memcpy(CMSG_DATA(cmsg), &p->ecn, ecn_size);
-      msg.msg_controllen = CMSG_SPACE(ecn_size);
-    } else {
-      msg.msg_controllen = 0;
-      msg.msg_control = nullptr;
-    }
-
-    // TODO: send all at once with sendmmsg()
-    if (::sendmsg(socket.native_handle(), &msg, 0) == -1) {
-      ec.assign(errno, system_category());
-      if (ec == errc::resource_unavailable_try_again ||
-          ec == errc::operation_would_block) {
-        // lsquic won't call our send_packets() callback again until we call
-        // lsquic_engine_send_unsent_packets()
-        // wait for the socket to become writeable again, so we can call that
-        socket.async_wait(udp::socket::wait_write,
-            [this] (error_code ec) {
-              if (!ec) {
-                on_writeable();
-              } // else fatal?
-            });
-        errno = ec.value(); // lsquic needs to see this errno
-      }
-      break;
-    }
-  }
-  return p;
-}
-
-constexpr size_t ecn_size = sizeof(int);
-#ifdef IP_RECVORIGDSTADDR
-constexpr size_t dstaddr4_size = sizeof(sockaddr_in);
-#else
-constexpr size_t dstaddr4_size = sizeof(in_pktinfo)
-#endif
-constexpr size_t dstaddr_size = std::max(dstaddr4_size, sizeof(in6_pktinfo));
-constexpr size_t max_control_size = CMSG_SPACE(ecn_size) + CMSG_SPACE(dstaddr_size);
-
-size_t socket_impl::recv_packet(iovec iov, udp::endpoint& peer,
-                                sockaddr_union& self, int& ecn,
-                                error_code& ec)
-{
-  auto msg = msghdr{};
-
-  msg.msg_name = peer.data();
-  msg.msg_namelen = peer.size();
-
-  msg.msg_iov = &iov;
-  msg.msg_iovlen = 1;
-
-  std::array<unsigned char, max_control_size> control;
-  msg.msg_control = control.data();
-  msg.msg_controllen = control.size();
-
-  const auto bytes = ::recvmsg(socket.native_handle(), &msg, 0);
-  if (bytes == -1) {
-    ec.assign(errno, system_category());
-    return 0;
-  }
-
-  if (local_addr.data()->sa_family == AF_INET6) {
-    ::memcpy(&self.addr6, local_addr.data(), sizeof(sockaddr_in6));
-  } else {
-    ::memcpy(&self.addr4, local_addr.data(), sizeof(sockaddr_in));
-  }
-
-  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-    if (cmsg->cmsg_level == IPPROTO_IP) {
-      if (cmsg->cmsg_type == IP_TOS) {
-        auto value = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
-        ecn = IPTOS_ECN(*value);
-#ifdef IP_RECVORIGDSTADDR
-      } else if (cmsg->cmsg_type == IP_ORIGDSTADDR) {
-        ::memcpy(&self.storage, CMSG_DATA(cmsg), sizeof(sockaddr_in));
-#else
-      } else if (cmsg->cmsg_type == IP_PKTINFO) {
-        auto info = reinterpret_cast<const in_pktinfo*>(CMSG_DATA(cmsg));
-        self.addr4.sin_addr = info->ipi_addr;
-#endif
-      }
-    } else if (cmsg->cmsg_level == IPPROTO_IPV6) {
-      if (cmsg->cmsg_type == IPV6_TCLASS) {
-        auto value = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
-        ecn = IPTOS_ECN(*value);
-      } else if (cmsg->cmsg_type == IPV6_PKTINFO) {
-        auto info = reinterpret_cast<const in6_pktinfo*>(CMSG_DATA(cmsg));
-        self.addr6.sin6_addr = info->ipi6_addr;
-      }
-    }
-  }
-  return bytes;
+  return transport->send_packets(begin, end, ec);
 }
 
-} // namespace detail
-} // namespace nexus::quic
+} // namespace nexus::quic::detail
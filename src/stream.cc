@@ -55,16 +55,39 @@ void stream_impl::read_headers(stream_header_read_operation& op)
 {
   auto lock = std::unique_lock{engine.mutex};
   if (stream_state::read_headers(state, op)) {
-    engine.process(lock);
+    engine.request_process(lock);
+  }
+}
+
+// reads that complete inline don't need a process() of their own. but
+// consuming buffered data can open the flow control window, so schedule the
+// update for the next turn of the event loop, where reads of other streams
+// share the pass
+static void after_read(engine_impl& engine, engine_lock& lock,
+                       receiving_stream_state::read_status status)
+{
+  switch (status) {
+    case receiving_stream_state::read_status::waiting:
+      engine.request_process(lock);
+      break;
+    case receiving_stream_state::read_status::consumed:
+      engine.arm_timer(engine_impl::timer_type::clock_type::now());
+      break;
+    case receiving_stream_state::read_status::completed:
+      break;
   }
 }
 
 void stream_impl::read_some(stream_data_operation& op)
 {
   auto lock = std::unique_lock{engine.mutex};
-  if (stream_state::read(state, op)) {
-    engine.process(lock);
-  }
+  after_read(engine, lock, stream_state::read(state, op));
+}
+
+void stream_impl::read_some_view(stream_read_view_operation& op)
+{
+  auto lock = std::unique_lock{engine.mutex};
+  after_read(engine, lock, stream_state::read_view(state, op));
 }
 
 void stream_impl::on_read()
@@ -76,7 +99,7 @@ void stream_impl::write_some(stream_data_operation& op)
 {
   auto lock = std::unique_lock{engine.mutex};
   if (stream_state::write(state, op)) {
-    engine.process(lock);
+    engine.request_process(lock);
   }
 }
 
@@ -84,7 +107,23 @@ void stream_impl::write_headers(stream_header_write_operation& op)
 {
   auto lock = std::unique_lock{engine.mutex};
   if (stream_state::write_headers(state, op)) {
-    engine.process(lock);
+    engine.request_process(lock);
+  }
+}
+
+void stream_impl::write_message(stream_message_write_operation& op)
+{
+  auto lock = std::unique_lock{engine.mutex};
+  if (stream_state::write_message(state, op)) {
+    engine.request_process(lock);
+  }
+}
+
+void stream_impl::write_some_from(stream_write_source_operation& op)
+{
+  auto lock = std::unique_lock{engine.mutex};
+  if (stream_state::write_source(state, op)) {
+    engine.request_process(lock);
   }
 }
 
@@ -98,7 +137,7 @@ void stream_impl::flush(error_code& ec)
   auto lock = std::unique_lock{engine.mutex};
   stream_state::flush(state, ec);
   if (!ec) {
-    engine.process(lock);
+    engine.request_process(lock);
   }
 }
 
@@ -107,7 +146,7 @@ void stream_impl::shutdown(int how, error_code& ec)
   auto lock = std::unique_lock{engine.mutex};
   stream_state::shutdown(state, how, ec);
   if (!ec) {
-    engine.process(lock);
+    engine.request_process(lock);
   }
 }
 
@@ -117,7 +156,7 @@ void stream_impl::close(stream_close_operation& op)
   const auto t = stream_state::close(state, op);
   if (t == stream_state::transition::open_to_closing) {
     conn.on_open_stream_closing(*this);
-    engine.process(lock);
+    engine.request_process(lock);
   }
 }
 
@@ -157,6 +196,8 @@ void stream_impl::reset()
     default:
       return; // nothing changed, return without calling process()
   }
+  // process now even with deferred_processing, so lsquic can't call back
+  // into this stream after the destructor returns
   engine.process(lock);
 }
 
@@ -195,6 +236,40 @@ stream_id stream::id() const
   return sid;
 }
 
+size_t stream::send_file(int fd, uint64_t offset, size_t length,
+                         error_code& ec)
+{
+  auto file = detail::mapped_file{fd, offset, length, ec};
+  return impl.send_file(std::move(file), ec);
+}
+
+size_t stream::send_file(int fd, uint64_t offset, size_t length)
+{
+  error_code ec;
+  const size_t bytes = send_file(fd, offset, length, ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  return bytes;
+}
+
+size_t stream::send_file(const char* path, uint64_t offset, size_t length,
+                         error_code& ec)
+{
+  auto file = detail::mapped_file{path, offset, length, ec};
+  return impl.send_file(std::move(file), ec);
+}
+
+size_t stream::send_file(const char* path, uint64_t offset, size_t length)
+{
+  error_code ec;
+  const size_t bytes = send_file(path, offset, length, ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  return bytes;
+}
+
 void stream::flush(error_code& ec)
 {
   impl.flush(ec);
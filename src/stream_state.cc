@@ -2,6 +2,8 @@
 #include <nexus/quic/detail/connection_impl.hpp>
 #include <nexus/quic/detail/socket_impl.hpp>
 #include <nexus/quic/detail/engine_impl.hpp>
+#include <algorithm>
+#include <cerrno>
 #include <lsquic.h>
 
 #include "recv_header_set.hpp"
@@ -27,6 +29,65 @@ void write_header(variant& state, lsquic_stream* handle, header_operation& op)
   state = header{&op};
 }
 
+// advance the operation's iovecs past the bytes written
+static void consume(data_operation& op, size_t bytes)
+{
+  op.bytes_transferred += bytes;
+  auto iov = op.iovs;
+  const auto end = op.iovs + op.num_iovs;
+  for (; iov != end && bytes >= iov->iov_len; ++iov) {
+    bytes -= iov->iov_len;
+  }
+  if (iov != end) {
+    iov->iov_base = static_cast<char*>(iov->iov_base) + bytes;
+    iov->iov_len -= bytes;
+  }
+  op.num_iovs = std::distance(iov, end);
+  std::move(iov, end, op.iovs);
+}
+
+// returns true once a write_all operation has written everything. a fin
+// operation then shuts down the sending side, so the fin goes out with the
+// last of the buffered data
+static bool write_done(lsquic_stream* handle, data_operation& op,
+                       error_code& ec)
+{
+  if (op.num_iovs > 0) {
+    return false;
+  }
+  if (op.fin && ::lsquic_stream_shutdown(handle, 1) == -1) {
+    ec.assign(errno, system_category());
+  }
+  return true;
+}
+
+// the state after a write_all operation completes
+static variant done_state(const data_operation& op)
+{
+  if (op.fin) {
+    return shutdown{};
+  }
+  return expecting_body{};
+}
+
+void write_message(variant& state, lsquic_stream* handle,
+                   message_operation& op)
+{
+  if (std::holds_alternative<shutdown>(state)) {
+    op.post(make_error_code(errc::bad_file_descriptor), 0);
+    return;
+  }
+  if (!std::holds_alternative<expecting_header>(state)) {
+    op.post(make_error_code(errc::invalid_argument), 0);
+    return;
+  }
+  if (::lsquic_stream_wantwrite(handle, 1) == -1) {
+    op.post(error_code{errno, system_category()}, 0);
+    return;
+  }
+  state = message{&op};
+}
+
 void write_body(variant& state, lsquic_stream* handle, data_operation& op)
 {
   if (std::holds_alternative<shutdown>(state)) {
@@ -37,6 +98,26 @@ void write_body(variant& state, lsquic_stream* handle, data_operation& op)
     op.post(make_error_code(errc::invalid_argument), 0);
     return;
   }
+  // if the stream has flow control credit, write now instead of waiting for
+  // on_write() during the next process()
+  const auto bytes = ::lsquic_stream_writev(handle, op.iovs, op.num_iovs);
+  if (bytes == -1) {
+    op.post(error_code{errno, system_category()}, 0);
+    return;
+  }
+  if (op.write_all) {
+    consume(op, bytes);
+    error_code ec;
+    if (write_done(handle, op, ec)) {
+      op.post(ec, op.bytes_transferred);
+      state = done_state(op);
+      return;
+    }
+  } else if (bytes > 0) {
+    op.post(error_code{}, bytes);
+    return;
+  }
+  // blocked, so wait for on_write()
   if (::lsquic_stream_wantwrite(handle, 1) == -1) {
     op.post(error_code{errno, system_category()}, 0);
     return;
@@ -44,38 +125,139 @@ void write_body(variant& state, lsquic_stream* handle, data_operation& op)
   state = body{&op};
 }
 
-void on_write_header(variant& state, lsquic_stream* handle)
+static lsquic_reader make_reader(source_operation& op)
 {
-  auto& h = *std::get_if<header>(&state);
-  error_code ec;
-  auto& fields = h.op->fields;
+  lsquic_reader reader;
+  reader.lsqr_read = op.read;
+  reader.lsqr_size = op.size;
+  reader.lsqr_ctx = op.source;
+  return reader;
+}
+
+void write_body_source(variant& state, lsquic_stream* handle,
+                       source_operation& op)
+{
+  if (std::holds_alternative<shutdown>(state)) {
+    op.post(make_error_code(errc::bad_file_descriptor), 0);
+    return;
+  }
+  if (!std::holds_alternative<expecting_body>(state)) {
+    op.post(make_error_code(errc::invalid_argument), 0);
+    return;
+  }
+  // pull as much as flow control allows now
+  auto reader = make_reader(op);
+  const auto bytes = ::lsquic_stream_writef(handle, &reader);
+  if (bytes == -1) {
+    op.post(error_code{errno, system_category()}, 0);
+    return;
+  }
+  op.bytes_transferred += bytes;
+  const bool done = op.write_all ? op.size(op.source) == 0 : bytes > 0;
+  if (done) {
+    op.post(error_code{}, op.bytes_transferred);
+    return;
+  }
+  // blocked, or more to write, so wait for on_write()
+  if (::lsquic_stream_wantwrite(handle, 1) == -1) {
+    op.post(error_code{errno, system_category()}, 0);
+    return;
+  }
+  state = body_source{&op};
+}
+
+// point the lsxpack_header at the field's name and value
+static void set_header(lsxpack_header& header, const h3::field& f)
+{
+  const char* buf = f.data();
+  const size_t name_offset = std::distance(buf, f.name().data());
+  const size_t name_len = f.name().size();
+  const size_t val_offset = std::distance(buf, f.value().data());
+  const size_t val_len = f.value().size();
+  lsxpack_header_set_offset2(&header, buf, name_offset, name_len,
+                             val_offset, val_len);
+  if (f.never_index()) {
+    header.flags = LSXPACK_NEVER_INDEX;
+  }
+}
 
-  // stack-allocate a lsxpack_header array
+// encode the fields and send them as a HEADERS frame. fields from the
+// optional template carry their static table index, so the encoder doesn't
+// have to search for them. template fields that are overridden by a field of
+// the same name are skipped
+static int send_headers(lsquic_stream* handle, const h3::header_template* tmpl,
+                        const h3::fields& fields, int eos)
+{
+  const size_t count = fields.size() + (tmpl ? tmpl->size() : 0);
+  // stack-allocate a lsxpack_header array, with room for every template field
   auto array = reinterpret_cast<lsxpack_header*>(
-      ::alloca(fields.size() * sizeof(lsxpack_header)));
+      ::alloca(count * sizeof(lsxpack_header)));
   int num_headers = 0;
-  for (auto f = fields.begin(); f != fields.end(); ++f, ++num_headers) {
-    auto& header = array[num_headers];
-    const char* buf = f->data();
-    const size_t name_offset = std::distance(buf, f->name().data());
-    const size_t name_len = f->name().size();
-    const size_t val_offset = std::distance(buf, f->value().data());
-    const size_t val_len = f->value().size();
-    lsxpack_header_set_offset2(&header, buf, name_offset, name_len,
-                               val_offset, val_len);
-    if (f->never_index()) {
-      header.flags = LSXPACK_NEVER_INDEX;
+  auto add_entries = [&] (const h3::header_template::entry* begin,
+                          const h3::header_template::entry* end) {
+    for (auto e = begin; e != end; ++e) {
+      if (!fields.empty() && fields.find(e->f->name()) != fields.end()) {
+        continue;
+      }
+      auto& header = array[num_headers++];
+      set_header(header, *e->f);
+      if (e->qpack_index >= 0) {
+        header.qpack_index = e->qpack_index;
+        header.flags = static_cast<lsxpack_flag>(
+            header.flags | LSXPACK_QPACK_IDX);
+      }
     }
+  };
+  if (tmpl) {
+    add_entries(tmpl->pseudo_begin(), tmpl->pseudo_end());
+  }
+  for (auto f = fields.begin(); f != fields.end(); ++f, ++num_headers) {
+    set_header(array[num_headers], *f);
+  }
+  if (tmpl) {
+    add_entries(tmpl->regular_begin(), tmpl->regular_end());
   }
   auto headers = lsquic_http_headers{num_headers, array};
-  if (::lsquic_stream_send_headers(handle, &headers, 0) == -1) {
+  return ::lsquic_stream_send_headers(handle, &headers, eos);
+}
+
+void on_write_header(variant& state, lsquic_stream* handle)
+{
+  auto& h = *std::get_if<header>(&state);
+  error_code ec;
+  if (send_headers(handle, nullptr, h.op->fields, 0) == -1) {
     ec.assign(errno, system_category());
   }
-
   h.op->defer(ec);
   state = expecting_body{};
 }
 
+void on_write_message(variant& state, lsquic_stream* handle)
+{
+  auto op = std::get_if<message>(&state)->op;
+  error_code ec;
+  consume(*op, 0); // skip any empty buffers
+  if (op->num_iovs == 0 && op->fin) {
+    // no body, so the fin goes out with the headers
+    if (send_headers(handle, op->tmpl, op->fields, 1) == -1) {
+      ec.assign(errno, system_category());
+    }
+    op->defer(ec, 0);
+    state = shutdown{};
+    return;
+  }
+  if (send_headers(handle, op->tmpl, op->fields, 0) == -1) {
+    ec.assign(errno, system_category());
+    op->defer(ec, 0);
+    state = expecting_body{};
+    return;
+  }
+  // write the body in the same pass, so it can share a packet with the
+  // headers
+  state = body{op};
+  on_write_body(state, handle);
+}
+
 void on_write_body(variant& state, lsquic_stream* handle)
 {
   auto& b = *std::get_if<body>(&state);
@@ -84,17 +266,55 @@ void on_write_body(variant& state, lsquic_stream* handle)
   if (bytes == -1) {
     bytes = 0;
     ec.assign(errno, system_category());
+  } else if (b.op->write_all) {
+    consume(*b.op, bytes);
+    if (!write_done(handle, *b.op, ec)) {
+      return; // keep the wantwrite for the rest
+    }
+    b.op->defer(ec, b.op->bytes_transferred);
+    state = done_state(*b.op);
+    return;
   }
   b.op->defer(ec, bytes);
   state = expecting_body{};
 }
 
+void on_write_body_source(variant& state, lsquic_stream* handle)
+{
+  auto& b = *std::get_if<body_source>(&state);
+  error_code ec;
+  auto reader = make_reader(*b.op);
+  const auto bytes = ::lsquic_stream_writef(handle, &reader);
+  if (bytes == -1) {
+    ec.assign(errno, system_category());
+  } else {
+    b.op->bytes_transferred += bytes;
+    if (b.op->write_all && b.op->size(b.op->source) > 0) {
+      return; // keep the wantwrite for the rest
+    }
+  }
+  b.op->defer(ec, b.op->bytes_transferred);
+  state = expecting_body{};
+}
+
+bool wants_write(const variant& state)
+{
+  // write_all operations stay in body/body_source between on_write() calls
+  // until they've written everything
+  return std::holds_alternative<body>(state)
+      || std::holds_alternative<body_source>(state);
+}
+
 void on_write(variant& state, lsquic_stream* handle)
 {
   if (std::holds_alternative<shutdown>(state)) {
     return;
   } else if (std::holds_alternative<header>(state)) {
     on_write_header(state, handle);
+  } else if (std::holds_alternative<message>(state)) {
+    on_write_message(state, handle);
+  } else if (std::holds_alternative<body_source>(state)) {
+    on_write_body_source(state, handle);
   } else {
     assert(std::holds_alternative<body>(state)); // expecting states shouldn't wantwrite
     on_write_body(state, handle);
@@ -109,12 +329,24 @@ int cancel(variant& state, error_code ec)
     }
     state = shutdown{};
     return 1;
+  } else if (std::holds_alternative<message>(state)) {
+    if (auto op = std::get_if<message>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, 0);
+    }
+    state = shutdown{};
+    return 1;
   } else if (std::holds_alternative<body>(state)) {
     if (auto op = std::get_if<body>(&state)->op; op) { // maybe destroy()ed
       op->defer(ec, 0);
     }
     state = shutdown{};
     return 1;
+  } else if (std::holds_alternative<body_source>(state)) {
+    if (auto op = std::get_if<body_source>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, 0);
+    }
+    state = shutdown{};
+    return 1;
   } else {
     return 0;
   }
@@ -126,10 +358,18 @@ void destroy(variant& state)
     auto& h = *std::get_if<header>(&state);
     h.op->destroy(error_code{});
     h.op = nullptr;
+  } else if (std::holds_alternative<message>(state)) {
+    auto& m = *std::get_if<message>(&state);
+    m.op->destroy(error_code{}, 0);
+    m.op = nullptr;
   } else if (std::holds_alternative<body>(state)) {
     auto& b = *std::get_if<body>(&state);
     b.op->destroy(error_code{}, 0);
     b.op = nullptr;
+  } else if (std::holds_alternative<body_source>(state)) {
+    auto& b = *std::get_if<body_source>(&state);
+    b.op->destroy(error_code{}, 0);
+    b.op = nullptr;
   }
 }
 
@@ -150,17 +390,106 @@ void read_header(variant& state, lsquic_stream* handle, header_operation& op)
   state = header{&op};
 }
 
-void read_body(variant& state, lsquic_stream* handle, data_operation& op)
+void read_request(variant& state, lsquic_stream* handle,
+                  request_operation& op)
+{
+  assert(std::holds_alternative<expecting_header>(state));
+  if (::lsquic_stream_wantread(handle, 1) == -1) {
+    op.defer(error_code{errno, system_category()}, false);
+    return;
+  }
+  state = request{&op};
+}
+
+read_status read_body(variant& state, lsquic_stream* handle,
+                      data_operation& op)
 {
   if (!std::holds_alternative<expecting_body>(state)) {
     op.post(make_error_code(errc::invalid_argument), 0);
-    return;
+    return read_status::completed;
   }
+  // if data or fin is already buffered, read it now instead of waiting for
+  // on_read() during the next process()
+  const auto bytes = ::lsquic_stream_readv(handle, op.iovs, op.num_iovs);
+  if (bytes >= 0) {
+    op.post(error_code{}, bytes);
+    return bytes > 0 ? read_status::consumed : read_status::completed;
+  }
+  if (errno != EWOULDBLOCK) {
+    op.post(error_code{errno, system_category()}, 0);
+    return read_status::completed;
+  }
+  // nothing buffered, so wait for on_read()
   if (::lsquic_stream_wantread(handle, 1) == -1) {
     op.post(error_code{errno, system_category()}, 0);
-    return;
+    return read_status::completed;
   }
   state = body{&op};
+  return read_status::waiting;
+}
+
+// the operation of a view read, and whether its visitor was called with any
+// data. readf() returns 0 both at the end of the stream and when the visitor
+// consumes nothing
+struct visit_context {
+  view_operation* op;
+  bool visited = false;
+};
+
+// lsquic_stream_readf() callback that passes each contiguous range of
+// buffered data to the operation's visitor
+static size_t visit_body(void* ctx, const unsigned char* buf,
+                         size_t len, int)
+{
+  if (len == 0) {
+    return 0;
+  }
+  auto c = static_cast<visit_context*>(ctx);
+  c->visited = true;
+  return c->op->visit(c->op, boost::asio::const_buffer(buf, len));
+}
+
+read_status read_body_view(variant& state, lsquic_stream* handle,
+                           view_operation& op)
+{
+  if (!std::holds_alternative<expecting_body>(state)) {
+    op.post(make_error_code(errc::invalid_argument), 0);
+    return read_status::completed;
+  }
+  // visit any data or fin that's already buffered
+  auto c = visit_context{&op};
+  const auto bytes = ::lsquic_stream_readf(handle, visit_body, &c);
+  if (bytes == 0 && !c.visited) {
+    op.post(make_error_code(stream_error::eof), 0);
+    return read_status::completed;
+  }
+  if (bytes >= 0) {
+    op.post(error_code{}, bytes);
+    return bytes > 0 ? read_status::consumed : read_status::completed;
+  }
+  if (errno != EWOULDBLOCK) {
+    op.post(error_code{errno, system_category()}, 0);
+    return read_status::completed;
+  }
+  // nothing buffered, so wait for on_read()
+  if (::lsquic_stream_wantread(handle, 1) == -1) {
+    op.post(error_code{errno, system_category()}, 0);
+    return read_status::completed;
+  }
+  state = body_view{&op};
+  return read_status::waiting;
+}
+
+// hand the received fields to the operation. swapping lets the header set
+// keep the operation's old name index for reuse instead of reallocating one,
+// and its old entries are cleared when the header set is released
+static void take_fields(h3::fields& fields, recv_header_set& headers)
+{
+  if (fields.get_allocator() == headers.fields.get_allocator()) {
+    fields.swap(headers.fields);
+  } else {
+    fields = std::move(headers.fields);
+  }
 }
 
 void on_read_header(variant& state, lsquic_stream* handle)
@@ -171,14 +500,47 @@ void on_read_header(variant& state, lsquic_stream* handle)
   if (!hset) {
     ec = make_error_code(stream_error::eof);
   } else {
-    auto headers = std::unique_ptr<recv_header_set>{
+    auto headers = recv_header_set_ptr{
         reinterpret_cast<recv_header_set*>(hset)}; // take ownership
-    h.op->fields = std::move(headers->fields);
+    take_fields(h.op->fields, *headers);
   }
   h.op->defer(ec);
   state = expecting_body{};
 }
 
+// lsquic_stream_readf() callback that notes whether any data is buffered,
+// without consuming it
+static size_t peek_body(void* ctx, const unsigned char*,
+                        size_t len, int)
+{
+  if (len > 0) {
+    *static_cast<bool*>(ctx) = true;
+  }
+  return 0;
+}
+
+void on_read_request(variant& state, lsquic_stream* handle)
+{
+  auto& r = *std::get_if<request>(&state);
+  error_code ec;
+  bool fin = false;
+  auto hset = ::lsquic_stream_get_hset(handle);
+  if (!hset) {
+    ec = make_error_code(stream_error::eof);
+  } else {
+    auto headers = recv_header_set_ptr{
+        reinterpret_cast<recv_header_set*>(hset)}; // take ownership
+    take_fields(r.op->fields, *headers);
+    // readf() returns 0 at the end of the stream, or -1 if no body has
+    // arrived yet
+    bool has_body = false;
+    const auto bytes = ::lsquic_stream_readf(handle, peek_body, &has_body);
+    fin = (bytes == 0 && !has_body);
+  }
+  r.op->defer(ec, fin);
+  state = expecting_body{};
+}
+
 void on_read_body(variant& state, lsquic_stream* handle)
 {
   auto& b = *std::get_if<body>(&state);
@@ -192,12 +554,32 @@ void on_read_body(variant& state, lsquic_stream* handle)
   state = expecting_body{};
 }
 
+void on_read_body_view(variant& state, lsquic_stream* handle)
+{
+  auto& b = *std::get_if<body_view>(&state);
+  auto c = visit_context{b.op};
+  error_code ec;
+  auto bytes = ::lsquic_stream_readf(handle, visit_body, &c);
+  if (bytes == -1) {
+    bytes = 0;
+    ec.assign(errno, system_category());
+  } else if (bytes == 0 && !c.visited) {
+    ec = make_error_code(stream_error::eof);
+  }
+  b.op->defer(ec, bytes);
+  state = expecting_body{};
+}
+
 void on_read(variant& state, lsquic_stream* handle)
 {
   if (std::holds_alternative<shutdown>(state)) {
     return;
   } else if (std::holds_alternative<header>(state)) {
     on_read_header(state, handle);
+  } else if (std::holds_alternative<request>(state)) {
+    on_read_request(state, handle);
+  } else if (std::holds_alternative<body_view>(state)) {
+    on_read_body_view(state, handle);
   } else {
     assert(std::holds_alternative<body>(state)); // expecting states shouldn't wantread
     on_read_body(state, handle);
@@ -212,12 +594,24 @@ int cancel(variant& state, error_code ec)
     }
     state = shutdown{};
     return 1;
+  } else if (std::holds_alternative<request>(state)) {
+    if (auto op = std::get_if<request>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, false);
+    }
+    state = shutdown{};
+    return 1;
   } else if (std::holds_alternative<body>(state)) {
     if (auto op = std::get_if<body>(&state)->op; op) { // maybe destroy()ed
       op->defer(ec, 0);
     }
     state = shutdown{};
     return 1;
+  } else if (std::holds_alternative<body_view>(state)) {
+    if (auto op = std::get_if<body_view>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, 0);
+    }
+    state = shutdown{};
+    return 1;
   } else {
     return 0;
   }
@@ -229,10 +623,18 @@ void destroy(variant& state)
     auto& h = *std::get_if<header>(&state);
     h.op->destroy(error_code{});
     h.op = nullptr;
+  } else if (std::holds_alternative<request>(state)) {
+    auto& r = *std::get_if<request>(&state);
+    r.op->destroy(error_code{}, false);
+    r.op = nullptr;
   } else if (std::holds_alternative<body>(state)) {
     auto& b = *std::get_if<body>(&state);
     b.op->destroy(error_code{}, 0);
     b.op = nullptr;
+  } else if (std::holds_alternative<body_view>(state)) {
+    auto& b = *std::get_if<body_view>(&state);
+    b.op->destroy(error_code{}, 0);
+    b.op = nullptr;
   }
 }
 
@@ -281,10 +683,24 @@ void accept(variant& state, stream_accept_operation& op)
   state = accepting{&op};
 }
 
+void accept_request(variant& state, stream_accept_request_operation& op)
+{
+  assert(std::holds_alternative<closed>(state));
+  state = accepting_request{&op};
+}
+
 void on_accept(variant& state, lsquic_stream* handle, bool is_http)
 {
   if (std::holds_alternative<accepting>(state)) {
     std::get_if<accepting>(&state)->op->defer(error_code{});
+  } else if (std::holds_alternative<accepting_request>(state)) {
+    // the operation completes once the request headers are read
+    assert(is_http);
+    auto op = std::get_if<accepting_request>(&state)->op;
+    state.emplace<open>(*handle, open::h3_tag{});
+    auto& o = *std::get_if<open>(&state);
+    receiving_stream_state::read_request(o.in, handle, *op);
+    return;
   } else { // accept() found an incoming stream
     assert(std::holds_alternative<closed>(state));
   }
@@ -295,19 +711,35 @@ void on_accept(variant& state, lsquic_stream* handle, bool is_http)
   }
 }
 
-bool read(variant& state, stream_data_operation& op)
+receiving_stream_state::read_status read(variant& state,
+                                         stream_data_operation& op)
 {
   if (std::holds_alternative<error>(state)) {
     op.post(std::get_if<error>(&state)->ec, 0);
     state = closed{};
-    return false;
+    return receiving_stream_state::read_status::completed;
   } else if (std::holds_alternative<open>(state)) {
     auto& o = *std::get_if<open>(&state);
-    receiving_stream_state::read_body(o.in, &o.handle, op);
-    return true;
+    return receiving_stream_state::read_body(o.in, &o.handle, op);
   } else {
     op.post(make_error_code(errc::bad_file_descriptor), 0);
-    return false;
+    return receiving_stream_state::read_status::completed;
+  }
+}
+
+receiving_stream_state::read_status read_view(
+    variant& state, stream_read_view_operation& op)
+{
+  if (std::holds_alternative<error>(state)) {
+    op.post(std::get_if<error>(&state)->ec, 0);
+    state = closed{};
+    return receiving_stream_state::read_status::completed;
+  } else if (std::holds_alternative<open>(state)) {
+    auto& o = *std::get_if<open>(&state);
+    return receiving_stream_state::read_body_view(o.in, &o.handle, op);
+  } else {
+    op.post(make_error_code(errc::bad_file_descriptor), 0);
+    return receiving_stream_state::read_status::completed;
   }
 }
 
@@ -351,6 +783,22 @@ bool write(variant& state, stream_data_operation& op)
   }
 }
 
+bool write_source(variant& state, stream_write_source_operation& op)
+{
+  if (std::holds_alternative<error>(state)) {
+    op.post(std::get_if<error>(&state)->ec, 0);
+    state = closed{};
+    return false;
+  } else if (std::holds_alternative<open>(state)) {
+    auto& o = *std::get_if<open>(&state);
+    sending_stream_state::write_body_source(o.out, &o.handle, op);
+    return true;
+  } else {
+    op.post(make_error_code(errc::bad_file_descriptor), 0);
+    return false;
+  }
+}
+
 bool write_headers(variant& state, stream_header_write_operation& op)
 {
   if (std::holds_alternative<error>(state)) {
@@ -367,12 +815,30 @@ bool write_headers(variant& state, stream_header_write_operation& op)
   }
 }
 
+bool write_message(variant& state, stream_message_write_operation& op)
+{
+  if (std::holds_alternative<error>(state)) {
+    op.post(std::get_if<error>(&state)->ec, 0);
+    state = closed{};
+    return false;
+  } else if (std::holds_alternative<open>(state)) {
+    auto& o = *std::get_if<open>(&state);
+    sending_stream_state::write_message(o.out, &o.handle, op);
+    return true;
+  } else {
+    op.post(make_error_code(errc::bad_file_descriptor), 0);
+    return false;
+  }
+}
+
 void on_write(variant& state)
 {
   assert(std::holds_alternative<open>(state));
   auto& o = *std::get_if<open>(&state);
   sending_stream_state::on_write(o.out, &o.handle);
-  ::lsquic_stream_wantwrite(&o.handle, 0);
+  if (!sending_stream_state::wants_write(o.out)) {
+    ::lsquic_stream_wantwrite(&o.handle, 0);
+  }
 }
 
 void flush(variant& state, error_code& ec)
@@ -444,6 +910,7 @@ transition close(variant& state, stream_close_operation& op)
   }
   if (!std::holds_alternative<open>(state)) {
     assert(!std::holds_alternative<accepting>(state)); // not visible yet
+    assert(!std::holds_alternative<accepting_request>(state)); // not visible yet
     assert(!std::holds_alternative<connecting>(state)); // not visible yet
     op.post(make_error_code(errc::not_connected));
     return transition::none;
@@ -468,6 +935,7 @@ transition on_close(variant& state)
   }
   if (!std::holds_alternative<open>(state)) {
     assert(!std::holds_alternative<accepting>(state)); // no lsquic_stream yet
+    assert(!std::holds_alternative<accepting_request>(state)); // no lsquic_stream yet
     assert(!std::holds_alternative<connecting>(state)); // no lsquic_stream yet
     return transition::none;
   }
@@ -488,6 +956,13 @@ transition on_error(variant& state, error_code ec)
     state = closed{};
     return transition::accepting_to_closed;
   }
+  if (std::holds_alternative<accepting_request>(state)) {
+    if (auto op = std::get_if<accepting_request>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, false);
+    }
+    state = closed{};
+    return transition::accepting_to_closed;
+  }
   if (std::holds_alternative<connecting>(state)) {
     if (auto op = std::get_if<connecting>(&state)->op; op) { // maybe destroy()ed
       op->defer(ec);
@@ -528,6 +1003,13 @@ transition reset(variant& state)
     state = closed{};
     return transition::accepting_to_closed;
   }
+  if (std::holds_alternative<accepting_request>(state)) {
+    if (auto op = std::get_if<accepting_request>(&state)->op; op) { // maybe destroy()ed
+      op->defer(ec, false);
+    }
+    state = closed{};
+    return transition::accepting_to_closed;
+  }
   if (std::holds_alternative<connecting>(state)) {
     if (auto op = std::get_if<connecting>(&state)->op; op) { // maybe destroy()ed
       op->defer(ec);
@@ -565,6 +1047,10 @@ void destroy(variant& state)
     auto& a = *std::get_if<accepting>(&state);
     a.op->destroy(error_code{});
     a.op = nullptr;
+  } else if (std::holds_alternative<accepting_request>(state)) {
+    auto& a = *std::get_if<accepting_request>(&state);
+    a.op->destroy(error_code{}, false);
+    a.op = nullptr;
   } else if (std::holds_alternative<connecting>(state)) {
     auto& c = *std::get_if<connecting>(&state);
     c.op->destroy(error_code{});
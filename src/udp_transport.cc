@@ -0,0 +1,607 @@
+#include <nexus/quic/socket.hpp>
+#include <nexus/quic/detail/engine_impl.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include <linux/filter.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <openssl/rand.h>
+#include <lsquic.h>
+
+#include "udp_transport.hpp"
+#include "uring.hpp"
+
+namespace nexus::quic {
+
+void prepare_socket(udp::socket& sock, bool is_server, error_code& ec)
+{
+  if (sock.non_blocking(true, ec); ec) {
+    return;
+  }
+  if (sock.set_option(receive_ecn{true}, ec); ec) {
+    return;
+  }
+  if (is_server) {
+    ec = nexus::detail::set_options(sock, receive_dstaddr{true},
+                                    udp::socket::reuse_address{true});
+  }
+}
+
+void prepare_socket(udp::socket& sock, bool is_server,
+                    const settings& s, error_code& ec)
+{
+  if (prepare_socket(sock, is_server, ec); ec) {
+    return;
+  }
+#ifdef SO_REUSEPORT
+  if (s.reuse_port) {
+    if (sock.set_option(reuse_port{true}, ec); ec) {
+      return;
+    }
+  }
+#endif
+#ifdef UDP_GRO
+  if (s.generic_receive_offload) {
+    // kernels without UDP_GRO just receive packets individually
+    if (sock.set_option(receive_gro{true}, ec);
+        ec == errc::no_protocol_option) {
+      ec.clear();
+    }
+  }
+#endif
+}
+
+void attach_reuseport_cbpf(udp::socket& sock, unsigned num_shards,
+                           error_code& ec)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  if (num_shards == 0) {
+    ec = make_error_code(errc::invalid_argument);
+    return;
+  }
+  // the program sees the udp payload. short-header packets (with the high
+  // bit of the first byte clear) return the first byte of their destination
+  // connection id modulo num_shards. long-header packets return an index
+  // past the end of the group, so the kernel falls back to its hash
+  sock_filter code[] = {
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+    BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 3, 0),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 1),
+    BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, num_shards),
+    BPF_STMT(BPF_RET | BPF_A, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+  };
+  sock_fprog prog = {};
+  prog.len = std::size(code);
+  prog.filter = code;
+  if (::setsockopt(sock.native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                   &prog, sizeof(prog)) == -1) {
+    ec.assign(errno, system_category());
+  } else {
+    ec.clear();
+  }
+#else
+  ec = make_error_code(errc::operation_not_supported);
+#endif
+}
+
+connection_id_generator sharded_connection_id_generator(uint8_t shard)
+{
+  return [shard] (unsigned char* data, size_t length) {
+    ::RAND_bytes(data, length);
+    data[0] = shard;
+  };
+}
+
+namespace detail {
+
+static udp::socket bind_socket(const boost::asio::any_io_executor& ex,
+                               const udp::endpoint& endpoint, bool is_server,
+                               const settings& s)
+{
+  // open the socket
+  auto socket = udp::socket{ex, endpoint.protocol()};
+  // set socket options before bind(), because the server enables REUSEADDR
+  error_code ec;
+  prepare_socket(socket, is_server, s, ec);
+  if (ec) {
+    throw system_error(ec);
+  }
+  socket.bind(endpoint); // may throw
+  return socket;
+}
+
+constexpr size_t ecn_size = sizeof(int);
+#ifdef IP_RECVORIGDSTADDR
+constexpr size_t dstaddr4_size = sizeof(sockaddr_in);
+#else
+constexpr size_t dstaddr4_size = sizeof(in_pktinfo);
+#endif
+constexpr size_t dstaddr_size = std::max(dstaddr4_size, sizeof(in6_pktinfo));
+constexpr size_t gro_size = sizeof(int);
+constexpr size_t max_control_size = CMSG_SPACE(ecn_size)
+                                  + CMSG_SPACE(dstaddr_size)
+                                  + CMSG_SPACE(gro_size);
+
+void receive_batch::resize(size_t count, size_t buffer_size,
+                           size_t control_size)
+{
+  this->buffer_size = buffer_size;
+  this->control_size = control_size;
+  headers.resize(count);
+  iovs.resize(count);
+  peers.resize(count);
+  controls.resize(count * control_size);
+  buffers.resize(count * buffer_size);
+
+  for (size_t i = 0; i < count; i++) {
+    iovs[i].iov_base = buffers.data() + i * buffer_size;
+    iovs[i].iov_len = buffer_size;
+
+    auto& msg = headers[i].msg_hdr;
+    msg.msg_name = &peers[i];
+    msg.msg_iov = &iovs[i];
+    msg.msg_iovlen = 1;
+    msg.msg_control = controls.data() + i * control_size;
+  }
+  reset();
+}
+
+void receive_batch::reset()
+{
+  for (auto& h : headers) {
+    h.msg_hdr.msg_namelen = sizeof(sockaddr_union);
+    h.msg_hdr.msg_controllen = control_size;
+    h.msg_hdr.msg_flags = 0;
+    h.msg_len = 0;
+  }
+}
+
+// the kernel accepts UDP_SEGMENT cmsgs on sockets where it can read the
+// UDP_SEGMENT option
+static bool probe_gso(udp::socket& socket)
+{
+#ifdef UDP_SEGMENT
+  int value = 0;
+  socklen_t size = sizeof(value);
+  return ::getsockopt(socket.native_handle(), SOL_UDP, UDP_SEGMENT,
+                      &value, &size) == 0;
+#else
+  return false;
+#endif
+}
+
+// prepare_socket() enables UDP_GRO where the kernel supports it
+static bool probe_gro(udp::socket& socket)
+{
+#ifdef UDP_GRO
+  int value = 0;
+  socklen_t size = sizeof(value);
+  return ::getsockopt(socket.native_handle(), SOL_UDP, UDP_GRO,
+                      &value, &size) == 0 && value != 0;
+#else
+  return false;
+#endif
+}
+
+static void init_buffers(udp_transport& t, const settings& s, packet_io io)
+{
+  // the engine advertises a max_udp_payload_size that fits these buffers
+  const size_t buffer_size = s.generic_receive_offload ?
+      max_gro_packet_size : max_packet_size;
+  t.recv_buffers.resize(s.receive_batch_size, buffer_size, max_control_size);
+  if (io == packet_io::io_uring) {
+    t.uring = make_uring_socket(t); // null if unavailable
+  }
+}
+
+udp_transport::udp_transport(socket_impl& socket, udp::socket&& sock,
+                             packet_io io)
+    : socket(socket),
+      sock(std::move(sock)),
+      yield_timer(this->sock.get_executor()),
+      local_addr(this->sock.local_endpoint()),
+      gso(socket.engine.config.generic_segmentation_offload &&
+          probe_gso(this->sock)),
+      gro(socket.engine.config.generic_receive_offload &&
+          probe_gro(this->sock))
+{
+  init_buffers(*this, socket.engine.config, io);
+}
+
+udp_transport::udp_transport(socket_impl& socket,
+                             const udp::endpoint& endpoint, bool is_server,
+                             packet_io io)
+    : socket(socket),
+      sock(bind_socket(socket.get_executor(), endpoint, is_server,
+                       socket.engine.config)),
+      yield_timer(this->sock.get_executor()),
+      local_addr(this->sock.local_endpoint()),
+      gso(socket.engine.config.generic_segmentation_offload &&
+          probe_gso(this->sock)),
+      gro(socket.engine.config.generic_receive_offload &&
+          probe_gro(this->sock))
+{
+  init_buffers(*this, socket.engine.config, io);
+}
+
+socket_features udp_transport::features() const
+{
+  socket_features f;
+  f.generic_segmentation_offload = gso;
+  f.generic_receive_offload = gro;
+  f.io_uring = uring && uring_receiving(*uring);
+  return f;
+}
+
+void udp_transport::start_recv()
+{
+  if (uring && uring_start_recv(*uring)) {
+    return;
+  }
+  sock.async_wait(udp::socket::wait_read,
+      [this] (error_code ec) {
+        socket.receiving = false;
+        if (!ec) {
+          on_readable();
+        } // XXX: else fatal? retry?
+      });
+}
+
+void udp_transport::cancel_recv()
+{
+  if (uring) {
+    uring_cancel_recv(*uring);
+  }
+  yield_timer.cancel();
+  sock.cancel();
+}
+
+void udp_transport::close()
+{
+  uring.reset();
+  yield_timer.cancel();
+  sock.close();
+}
+
+void udp_transport::packet_in(const unsigned char* data, size_t length,
+                              const sockaddr* peer, msghdr& control)
+{
+  sockaddr_union self;
+  int ecn = 0;
+  size_t segment_size = 0;
+  read_control(control, self, ecn, segment_size);
+
+  // with gro, the buffer may contain several packets from the same peer.
+  // each is segment_size bytes except for the last, which may be smaller
+  if (segment_size == 0) {
+    segment_size = length;
+  } else if (segment_size < length) {
+    socket.stats.coalesced_receives++;
+  }
+  for (size_t offset = 0; offset < length; offset += segment_size) {
+    const size_t size = std::min(segment_size, length - offset);
+    socket.packet_in(data + offset, size, &self.addr, peer, ecn);
+  }
+}
+
+void udp_transport::on_readable()
+{
+  const size_t budget = socket.engine.config.receive_budget;
+  size_t received = 0;
+  error_code ec;
+  for (;;) {
+    const auto count = recv_packets(ec);
+    if (ec) {
+      if (ec == errc::resource_unavailable_try_again ||
+          ec == errc::operation_would_block) {
+        socket.start_recv();
+      } // XXX: else fatal? retry?
+      return;
+    }
+
+    auto lock = std::unique_lock{socket.engine.mutex};
+    socket.stats.receive_calls++;
+
+    for (size_t i = 0; i < count; i++) {
+      auto& msg = recv_buffers.headers[i].msg_hdr;
+      if (msg.msg_flags & MSG_TRUNC) {
+        continue; // drop packets that didn't fit in the buffer
+      }
+      auto data = static_cast<const unsigned char*>(msg.msg_iov->iov_base);
+      packet_in(data, recv_buffers.headers[i].msg_len,
+                &recv_buffers.peers[i].addr, msg);
+    }
+    // process the whole batch at once
+    socket.engine.process(lock);
+
+    // keep reading until recvmmsg() fails with EAGAIN. the reactor only
+    // reports readiness again when more packets arrive, so waiting on a
+    // partially-drained socket could leave packets unread
+    received += count;
+    if (received >= budget) {
+      // the socket may still be readable, but yield to the other sockets
+      // and handlers on the executor before reading more
+      socket.stats.receive_yields++;
+      yield_recv();
+      return;
+    }
+  }
+}
+
+void udp_transport::yield_recv()
+{
+  socket.receiving = true; // cancel_recv() cancels the timer
+  yield_timer.expires_at(boost::asio::steady_timer::clock_type::now());
+  yield_timer.async_wait(
+      [this] (error_code ec) {
+        if (!ec) { // the transport may be gone if canceled
+          socket.receiving = false;
+          on_readable();
+        }
+      });
+}
+
+void udp_transport::on_writeable()
+{
+  auto lock = std::scoped_lock{socket.engine.mutex};
+  ::lsquic_engine_send_unsent_packets(socket.engine.handle.get());
+}
+
+void send_batch::resize(size_t count, size_t num_iovs)
+{
+  if (headers.size() < count) {
+    headers.resize(count);
+    controls.resize(count * control_size);
+    segments.resize(count);
+  }
+  if (iovs.size() < num_iovs) {
+    iovs.resize(num_iovs);
+  }
+}
+
+// add ECN and UDP_SEGMENT control messages to the message, if requested
+static void set_control(msghdr& msg, unsigned char* control, int ecn,
+                        uint16_t segment_size)
+{
+  msg.msg_control = control;
+  msg.msg_controllen = send_batch::control_size;
+  size_t length = 0;
+
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (ecn) {
+    if (static_cast<const sockaddr*>(msg.msg_name)->sa_family == AF_INET) {
+      cmsg->cmsg_level = IPPROTO_IP;
+      cmsg->cmsg_type = IP_TOS;
+    } else {
+      cmsg->cmsg_level = IPPROTO_IPV6;
+      cmsg->cmsg_type = IPV6_TCLASS;
+    }
+    cmsg->cmsg_len = CMSG_LEN(ecn_size);
+    ::memcpy(CMSG_DATA(cmsg), &ecn, ecn_size);
+    length += CMSG_SPACE(ecn_size);
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+  }
+#ifdef UDP_SEGMENT
+  if (segment_size) {
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(segment_size));
+    ::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    length += CMSG_SPACE(sizeof(segment_size));
+  }
+#endif
+
+  if (length) {
+    msg.msg_controllen = length;
+  } else {
+    msg.msg_control = nullptr;
+    msg.msg_controllen = 0;
+  }
+}
+
+static size_t packet_size(const lsquic_out_spec& spec)
+{
+  size_t size = 0;
+  for (size_t i = 0; i < spec.iovlen; i++) {
+    size += spec.iov[i].iov_len;
+  }
+  return size;
+}
+
+static bool same_address(const sockaddr* lhs, const sockaddr* rhs)
+{
+  if (lhs->sa_family != rhs->sa_family) {
+    return false;
+  }
+  if (lhs->sa_family == AF_INET) {
+    auto l = reinterpret_cast<const sockaddr_in*>(lhs);
+    auto r = reinterpret_cast<const sockaddr_in*>(rhs);
+    return l->sin_port == r->sin_port
+        && l->sin_addr.s_addr == r->sin_addr.s_addr;
+  } else {
+    auto l = reinterpret_cast<const sockaddr_in6*>(lhs);
+    auto r = reinterpret_cast<const sockaddr_in6*>(rhs);
+    return l->sin6_port == r->sin6_port
+        && ::memcmp(&l->sin6_addr, &r->sin6_addr, sizeof(in6_addr)) == 0;
+  }
+}
+
+// the kernel's UDP_MAX_SEGMENTS
+constexpr size_t max_gso_segments = 64;
+// the largest UDP payload that fits in an IPv6 datagram
+constexpr size_t max_gso_bytes = 65535 - sizeof(udphdr) - 40;
+
+void udp_transport::on_send_blocked()
+{
+  // lsquic won't call our send_packets() callback again until we call
+  // lsquic_engine_send_unsent_packets()
+  // wait for the socket to become writeable again, so we can call that
+  sock.async_wait(udp::socket::wait_write,
+      [this] (error_code ec) {
+        if (!ec) {
+          on_writeable();
+        } // else fatal?
+      });
+}
+
+auto udp_transport::send_packets(const lsquic_out_spec* begin,
+                               const lsquic_out_spec* end,
+                               error_code& ec)
+  -> const lsquic_out_spec*
+{
+  // send until we encounter a packet with a different peer_ctx
+  auto run_end = begin;
+  size_t num_iovs = 0;
+  while (run_end < end && run_end->peer_ctx == begin->peer_ctx) {
+    num_iovs += run_end->iovlen;
+    ++run_end;
+  }
+  send_buffers.resize(std::distance(begin, run_end), num_iovs);
+
+  size_t count = 0; // number of messages
+  bool segmented = false;
+  iovec* iov = send_buffers.iovs.data();
+  for (auto p = begin; p < run_end; ++count) {
+    auto& msg = send_buffers.headers[count].msg_hdr;
+    msg.msg_name = const_cast<void*>(static_cast<const void*>(p->dest_sa));
+    if (p->dest_sa->sa_family == AF_INET) {
+      msg.msg_namelen = sizeof(struct sockaddr_in);
+    } else {
+      msg.msg_namelen = sizeof(struct sockaddr_in6);
+    }
+    msg.msg_iov = iov;
+    msg.msg_flags = 0;
+
+    // with gso, combine the following packets for the same peer into this
+    // message as long as they're the same size. only the last may be smaller
+    const size_t segment_size = packet_size(*p);
+    size_t size = 0;
+    size_t last_size = 0;
+    uint16_t segments = 0;
+    const auto first = p;
+    do {
+      iov = std::copy(p->iov, p->iov + p->iovlen, iov);
+      last_size = packet_size(*p);
+      size += last_size;
+      ++segments;
+      ++p;
+    } while (gso && p < run_end &&
+             segments < max_gso_segments &&
+             last_size == segment_size &&
+             p->ecn == first->ecn &&
+             packet_size(*p) <= segment_size &&
+             size + packet_size(*p) <= max_gso_bytes &&
+             same_address(p->dest_sa, first->dest_sa));
+
+    msg.msg_iovlen = std::distance(msg.msg_iov, iov);
+    send_buffers.segments[count] = segments;
+    if (segments > 1) {
+      segmented = true;
+    }
+    auto control = send_buffers.controls.data() +
+        count * send_batch::control_size;
+    set_control(msg, control, first->ecn, segments > 1 ? segment_size : 0);
+  }
+
+  const int sent = ::sendmmsg(sock.native_handle(),
+                              send_buffers.headers.data(), count, 0);
+  if (sent == -1) {
+    ec.assign(errno, system_category());
+    if (segmented && (ec == errc::io_error || ec == errc::invalid_argument)) {
+      // the kernel or device rejected gso. disable it and send the packets
+      // individually instead
+      gso = false;
+      ec.clear();
+      return send_packets(begin, end, ec);
+    }
+    if (ec == errc::resource_unavailable_try_again ||
+        ec == errc::operation_would_block) {
+      on_send_blocked();
+      errno = ec.value(); // lsquic needs to see this errno
+    }
+    return begin;
+  }
+
+  // count the packets in the messages that were sent
+  size_t packets = 0;
+  for (int i = 0; i < sent; i++) {
+    packets += send_buffers.segments[i];
+    if (send_buffers.segments[i] > 1) {
+      socket.stats.segmented_sends++;
+    }
+  }
+  socket.stats.send_calls++;
+  socket.stats.packets_sent += packets;
+
+  if (static_cast<size_t>(sent) < count) {
+    // the kernel stopped before the end of the batch, either because the
+    // socket buffer filled up or because of an error that the next call would
+    // report. in either case, retry the rest once the socket is writeable
+    ec = make_error_code(errc::resource_unavailable_try_again);
+    on_send_blocked();
+    errno = ec.value(); // lsquic needs to see this errno
+  }
+  return std::next(begin, packets);
+}
+
+size_t udp_transport::recv_packets(error_code& ec)
+{
+  recv_buffers.reset();
+  const int count = ::recvmmsg(sock.native_handle(),
+                               recv_buffers.headers.data(),
+                               recv_buffers.headers.size(), 0, nullptr);
+  if (count == -1) {
+    ec.assign(errno, system_category());
+    return 0;
+  }
+  return count;
+}
+
+void udp_transport::read_control(msghdr& msg, sockaddr_union& self,
+                               int& ecn, size_t& segment_size) const
+{
+  if (local_addr.data()->sa_family == AF_INET6) {
+    ::memcpy(&self.addr6, local_addr.data(), sizeof(sockaddr_in6));
+  } else {
+    ::memcpy(&self.addr4, local_addr.data(), sizeof(sockaddr_in));
+  }
+
+  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IP) {
+      if (cmsg->cmsg_type == IP_TOS) {
+        auto value = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+        ecn = IPTOS_ECN(*value);
+#ifdef IP_RECVORIGDSTADDR
+      } else if (cmsg->cmsg_type == IP_ORIGDSTADDR) {
+        ::memcpy(&self.storage, CMSG_DATA(cmsg), sizeof(sockaddr_in));
+#else
+      } else if (cmsg->cmsg_type == IP_PKTINFO) {
+        auto info = reinterpret_cast<const in_pktinfo*>(CMSG_DATA(cmsg));
+        self.addr4.sin_addr = info->ipi_addr;
+#endif
+      }
+    } else if (cmsg->cmsg_level == IPPROTO_IPV6) {
+      if (cmsg->cmsg_type == IPV6_TCLASS) {
+        auto value = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+        ecn = IPTOS_ECN(*value);
+      } else if (cmsg->cmsg_type == IPV6_PKTINFO) {
+        auto info = reinterpret_cast<const in6_pktinfo*>(CMSG_DATA(cmsg));
+        self.addr6.sin6_addr = info->ipi6_addr;
+      }
+#ifdef UDP_GRO
+    } else if (cmsg->cmsg_level == SOL_UDP) {
+      if (cmsg->cmsg_type == UDP_GRO) {
+        int value = 0;
+        ::memcpy(&value, CMSG_DATA(cmsg), sizeof(value));
+        segment_size = value;
+      }
+#endif
+    }
+  }
+}
+
+} // namespace detail
+} // namespace nexus::quic
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <boost/asio/steady_timer.hpp>
+#include <nexus/quic/detail/packet_transport.hpp>
+#include <nexus/quic/detail/socket_impl.hpp>
+
+namespace nexus::quic::detail {
+
+struct uring_socket;
+
+struct uring_deleter { void operator()(uring_socket* u) const; };
+using uring_socket_ptr = std::unique_ptr<uring_socket, uring_deleter>;
+
+union sockaddr_union {
+  sockaddr_storage storage;
+  sockaddr addr;
+  sockaddr_in addr4;
+  sockaddr_in6 addr6;
+};
+
+/// storage for a batch of packets received with recvmmsg()
+struct receive_batch {
+  std::vector<mmsghdr> headers;
+  std::vector<iovec> iovs;
+  std::vector<sockaddr_union> peers;
+  std::vector<unsigned char> controls;
+  std::vector<unsigned char> buffers;
+  size_t buffer_size = 0;
+  size_t control_size = 0;
+
+  /// allocate storage for 'count' packets, and point each message header at
+  /// its own packet buffer, peer address and control buffer
+  void resize(size_t count, size_t buffer_size, size_t control_size);
+  /// reset the message header fields that recvmmsg() overwrites
+  void reset();
+  size_t size() const { return headers.size(); }
+};
+
+/// storage for a batch of packets sent with sendmmsg()
+struct send_batch {
+  // room for ECN and UDP_SEGMENT control messages per message
+  static constexpr size_t control_size = CMSG_SPACE(sizeof(int))
+                                       + CMSG_SPACE(sizeof(uint16_t));
+
+  std::vector<mmsghdr> headers;
+  std::vector<unsigned char> controls;
+  // number of packets in each message, greater than 1 for GSO
+  std::vector<uint16_t> segments;
+  // each message's iovecs are copied here, because GSO combines the iovecs
+  // of several packets into a single message
+  std::vector<iovec> iovs;
+
+  /// make room for at least 'count' messages and 'num_iovs' iovecs
+  void resize(size_t count, size_t num_iovs);
+};
+
+/// packet transport over a kernel UDP socket
+struct udp_transport : packet_transport {
+  socket_impl& socket;
+  udp::socket sock;
+  // expires immediately to continue reading after yielding to the executor
+  boost::asio::steady_timer yield_timer;
+  udp::endpoint local_addr; // socket's bound address
+  receive_batch recv_buffers;
+  send_batch send_buffers;
+  // send packet trains with UDP generic segmentation offload
+  bool gso = false;
+  // receive coalesced packet trains with UDP generic receive offload
+  bool gro = false;
+  // receives with io_uring, or null to use the reactor
+  uring_socket_ptr uring;
+
+  udp_transport(socket_impl& socket, udp::socket&& sock, packet_io io);
+  udp_transport(socket_impl& socket, const udp::endpoint& endpoint,
+                bool is_server, packet_io io);
+
+  udp::endpoint local_endpoint() const override { return local_addr; }
+  socket_features features() const override;
+
+  void start_recv() override;
+  void cancel_recv() override;
+
+  const lsquic_out_spec* send_packets(const lsquic_out_spec* begin,
+                                      const lsquic_out_spec* end,
+                                      error_code& ec) override;
+
+  void close() override;
+
+  void on_readable();
+  void yield_recv();
+  void on_writeable();
+  void on_send_blocked();
+
+  size_t recv_packets(error_code& ec);
+  void packet_in(const unsigned char* data, size_t length,
+                 const sockaddr* peer, msghdr& control);
+  void read_control(msghdr& msg, sockaddr_union& self, int& ecn,
+                    size_t& segment_size) const;
+};
+
+} // namespace nexus::quic::detail
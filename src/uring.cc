@@ -0,0 +1,304 @@
+#include "uring.hpp"
+#include <cerrno>
+
+#ifdef NEXUS_HAVE_IO_URING
+
+#include <algorithm>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <nexus/quic/detail/engine_impl.hpp>
+#include <liburing.h>
+
+namespace nexus::quic::detail {
+
+namespace {
+
+// the only buffer group registered with the receive ring
+constexpr int buffer_group = 0;
+// the receive ring only needs room for its multishot recvmsg
+constexpr unsigned recv_ring_entries = 8;
+
+unsigned round_up_pow2(unsigned n)
+{
+  unsigned result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+struct ring_handle {
+  io_uring ring;
+
+  ring_handle(unsigned entries, io_uring_params& params) {
+    const int r = ::io_uring_queue_init_params(entries, &ring, &params);
+    if (r < 0) {
+      throw system_error(error_code{-r, system_category()});
+    }
+  }
+  ~ring_handle() {
+    ::io_uring_queue_exit(&ring);
+  }
+};
+
+// a ring of buffers that the kernel selects from for each received packet
+struct provided_buffers {
+  io_uring& ring;
+  io_uring_buf_ring* handle;
+  unsigned count;
+  size_t size;
+  std::vector<unsigned char> storage;
+
+  provided_buffers(io_uring& ring, unsigned count, size_t size)
+    : ring(ring), count(count), size(size), storage(count * size)
+  {
+    int r = 0;
+    handle = ::io_uring_setup_buf_ring(&ring, count, buffer_group, 0, &r);
+    if (!handle) {
+      throw system_error(error_code{-r, system_category()});
+    }
+    for (unsigned i = 0; i < count; i++) {
+      add(i, i);
+    }
+    ::io_uring_buf_ring_advance(handle, count);
+  }
+  ~provided_buffers() {
+    ::io_uring_free_buf_ring(&ring, handle, count, buffer_group);
+  }
+
+  unsigned char* data(unsigned id) { return storage.data() + id * size; }
+
+  // return a buffer to the kernel. takes effect on advance()
+  void add(unsigned id, int offset) {
+    ::io_uring_buf_ring_add(handle, data(id), size, id,
+                            ::io_uring_buf_ring_mask(count), offset);
+  }
+};
+
+io_uring_params recv_params(unsigned buffer_count)
+{
+  io_uring_params params = {};
+  // room for a completion per provided buffer, and then some
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = buffer_count * 2;
+  return params;
+}
+
+} // anonymous namespace
+
+struct uring_socket {
+  udp_transport& transport;
+  io_uring_params rparams;
+  ring_handle recv_ring;
+  provided_buffers buffers;
+  // readiness of the receive ring's completion queue
+  boost::asio::posix::stream_descriptor recv_ready;
+  // expires immediately to continue reading completions after yielding to
+  // the executor
+  boost::asio::steady_timer recv_yield;
+  // template for the multishot recvmsg, which only reads the name and
+  // control lengths
+  msghdr recv_msg = {};
+  bool recv_armed = false;
+  bool recv_waiting = false;
+  bool recv_supported = true;
+  bool recv_succeeded = false;
+
+  uring_socket(udp_transport& transport, unsigned buffer_count)
+    : transport(transport),
+      rparams(recv_params(buffer_count)),
+      recv_ring(recv_ring_entries, rparams),
+      buffers(recv_ring.ring, buffer_count,
+              sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_union) +
+              transport.recv_buffers.control_size +
+              transport.recv_buffers.buffer_size),
+      recv_ready(transport.socket.get_executor(), recv_ring.ring.ring_fd),
+      recv_yield(transport.socket.get_executor())
+  {
+    recv_msg.msg_namelen = sizeof(sockaddr_union);
+    recv_msg.msg_controllen = transport.recv_buffers.control_size;
+  }
+  ~uring_socket() {
+    // the ring owns its file descriptor
+    recv_ready.release();
+  }
+
+  void arm_recv();
+  void wait_recv();
+  void yield_recv();
+  void on_recv_ready();
+};
+
+void uring_socket::arm_recv()
+{
+  auto sqe = ::io_uring_get_sqe(&recv_ring.ring);
+  ::io_uring_prep_recvmsg_multishot(sqe, transport.sock.native_handle(),
+                                    &recv_msg, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffer_group;
+  ::io_uring_submit(&recv_ring.ring);
+  recv_armed = true;
+}
+
+void uring_socket::wait_recv()
+{
+  if (recv_waiting) {
+    return;
+  }
+  recv_waiting = true;
+  recv_ready.async_wait(boost::asio::posix::descriptor_base::wait_read,
+      [this] (error_code ec) {
+        if (!ec) {
+          on_recv_ready();
+        }
+      });
+}
+
+void uring_socket::yield_recv()
+{
+  recv_waiting = true;
+  recv_yield.expires_at(boost::asio::steady_timer::clock_type::now());
+  recv_yield.async_wait(
+      [this] (error_code ec) {
+        if (!ec) {
+          on_recv_ready();
+        }
+      });
+}
+
+void uring_socket::on_recv_ready()
+{
+  auto& socket = transport.socket;
+  auto lock = std::unique_lock{socket.engine.mutex};
+  recv_waiting = false;
+  socket.receiving = false;
+
+  const unsigned budget = socket.engine.config.receive_budget;
+  bool more = false; // completions left over for the next pass
+  unsigned head = 0;
+  unsigned seen = 0;
+  int recycled = 0;
+  io_uring_cqe* cqe = nullptr;
+  io_uring_for_each_cqe(&recv_ring.ring, head, cqe) {
+    if (seen == budget) {
+      more = true;
+      break;
+    }
+    seen++;
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+      recv_armed = false; // the multishot ended, so arm it again below
+    }
+    if (cqe->res < 0) {
+      if (cqe->res == -EINVAL && !recv_succeeded) {
+        recv_supported = false; // kernel predates multishot recvmsg
+      }
+      // -ENOBUFS means we ran out of buffers. they're recycled below
+      continue;
+    }
+    recv_succeeded = true;
+    if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+      continue;
+    }
+    const unsigned id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+    auto out = ::io_uring_recvmsg_validate(buffers.data(id), cqe->res,
+                                           &recv_msg);
+    if (out && !(out->flags & MSG_TRUNC)) {
+      // point a msghdr at the control messages for read_control()
+      auto name = static_cast<unsigned char*>(::io_uring_recvmsg_name(out));
+      msghdr control = {};
+      control.msg_control = name + recv_msg.msg_namelen;
+      control.msg_controllen = out->controllen;
+
+      auto data = static_cast<const unsigned char*>(
+          ::io_uring_recvmsg_payload(out, &recv_msg));
+      const size_t length = ::io_uring_recvmsg_payload_length(
+          out, cqe->res, &recv_msg);
+      transport.packet_in(data, length, reinterpret_cast<sockaddr*>(name),
+                          control);
+    }
+    buffers.add(id, recycled++);
+  }
+  ::io_uring_buf_ring_advance(buffers.handle, recycled);
+  ::io_uring_cq_advance(&recv_ring.ring, seen);
+  if (seen > 0) {
+    socket.stats.receive_calls++; // each pass reads a batch of completions
+  }
+
+  // process the whole batch at once
+  socket.engine.process(lock);
+
+  if (more) {
+    // yield to the other handlers on the executor, then continue. waiting on
+    // the ring's descriptor would stall, because the reactor only reports
+    // readiness for completions that arrive after this
+    socket.stats.receive_yields++;
+    socket.receiving = true;
+    yield_recv();
+    return;
+  }
+  socket.start_recv();
+}
+
+void uring_deleter::operator()(uring_socket* u) const
+{
+  delete u;
+}
+
+uring_socket_ptr make_uring_socket(udp_transport& transport)
+{
+  const auto& config = transport.socket.engine.config;
+  const auto buffer_count = round_up_pow2(
+      std::max<unsigned>(config.receive_batch_size, 2));
+  try {
+    return uring_socket_ptr{new uring_socket(transport, buffer_count)};
+  } catch (const system_error&) {
+    return nullptr; // fall back to the reactor
+  }
+}
+
+bool uring_start_recv(uring_socket& u)
+{
+  if (!u.recv_supported) {
+    return false;
+  }
+  if (!u.recv_armed) {
+    u.arm_recv();
+  }
+  u.wait_recv();
+  return true;
+}
+
+bool uring_receiving(const uring_socket& u)
+{
+  return u.recv_succeeded;
+}
+
+void uring_cancel_recv(uring_socket& u)
+{
+  // the multishot stays armed, and packets that arrive in the meantime are
+  // processed once we start receiving again
+  u.recv_waiting = false;
+  u.recv_ready.cancel();
+  u.recv_yield.cancel();
+}
+
+} // namespace nexus::quic::detail
+
+#else // !NEXUS_HAVE_IO_URING
+
+namespace nexus::quic::detail {
+
+void uring_deleter::operator()(uring_socket*) const {}
+
+uring_socket_ptr make_uring_socket(udp_transport&)
+{
+  return nullptr;
+}
+
+bool uring_start_recv(uring_socket&) { return false; }
+bool uring_receiving(const uring_socket&) { return false; }
+void uring_cancel_recv(uring_socket&) {}
+
+} // namespace nexus::quic::detail
+
+#endif // !NEXUS_HAVE_IO_URING
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "udp_transport.hpp"
+
+namespace nexus::quic::detail {
+
+/// create an io_uring backend for the transport's socket. returns null if
+/// the library was built without liburing, or if the kernel doesn't support
+/// io_uring
+uring_socket_ptr make_uring_socket(udp_transport& transport);
+
+/// arm the multishot receive and wait for its completions. returns false if
+/// the kernel can't receive with io_uring, so the caller should fall back to
+/// the reactor
+bool uring_start_recv(uring_socket& u);
+
+/// return whether packets are received with io_uring. this only becomes
+/// true once the multishot receive completes with a packet, so it stays
+/// false if the kernel rejects it
+bool uring_receiving(const uring_socket& u);
+
+/// stop waiting for receive completions
+void uring_cancel_recv(uring_socket& u);
+
+} // namespace nexus::quic::detail
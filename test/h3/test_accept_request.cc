@@ -0,0 +1,261 @@
+#include <nexus/h3/server.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <nexus/h3/client.hpp>
+#include <nexus/h3/stream.hpp>
+#include <nexus/global_init.hpp>
+#include <nexus/quic/detail/engine_impl.hpp>
+#include <lsquic.h>
+
+#include "certificate.hpp"
+#include "recv_header_set.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& ec) {
+  return [&] (error_code e, size_t = 0) { ec = e; };
+}
+
+} // anonymous namespace
+
+class AcceptRequest : public testing::Test {
+ public:
+  static constexpr const char* alpn = "\02h3";
+
+  boost::asio::io_context context;
+  global::context global = global::init_client_server();
+
+  ssl::context ssl = test::init_server_context(alpn);
+  ssl::context sslc = test::init_client_context(alpn);
+
+  h3::server server{context.get_executor()};
+  boost::asio::ip::address localhost = boost::asio::ip::make_address("127.0.0.1");
+  h3::acceptor acceptor{server, udp::endpoint{localhost, 0}, ssl};
+  h3::server_connection sconn{acceptor};
+  h3::stream sstream{sconn};
+
+  h3::client client{context.get_executor(), udp::endpoint{}, sslc};
+  h3::client_connection cconn{client, acceptor.local_endpoint(), "host"};
+  h3::stream cstream{cconn};
+
+  h3::fields request;
+  h3::fields received;
+  std::optional<error_code> accept_request_ec;
+  bool accept_request_fin = false;
+
+  void SetUp() override
+  {
+    acceptor.listen(16);
+
+    std::optional<error_code> cstream_connect_ec;
+    cconn.async_connect(cstream, capture(cstream_connect_ec));
+
+    std::optional<error_code> accept_ec;
+    acceptor.async_accept(sconn, capture(accept_ec));
+
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(cstream_connect_ec);
+    EXPECT_EQ(ok, *cstream_connect_ec);
+    ASSERT_TRUE(accept_ec);
+    EXPECT_EQ(ok, *accept_ec);
+
+    request.insert(":method", "GET");
+    request.insert(":path", "/");
+  }
+
+  void accept_request()
+  {
+    sconn.async_accept_request(sstream, received,
+        [this] (error_code ec, bool fin) {
+          accept_request_ec = ec;
+          accept_request_fin = fin;
+        });
+  }
+};
+
+TEST_F(AcceptRequest, without_body)
+{
+  accept_request();
+  context.poll();
+  ASSERT_FALSE(accept_request_ec);
+
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(ok, *write_request_ec);
+  ASSERT_TRUE(accept_request_ec);
+  EXPECT_EQ(ok, *accept_request_ec);
+  EXPECT_TRUE(accept_request_fin);
+  EXPECT_EQ(2, received.size());
+  EXPECT_TRUE(sstream.is_open());
+}
+
+TEST_F(AcceptRequest, with_body)
+{
+  accept_request();
+
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request,
+                              boost::asio::buffer(std::string_view{"1234"}),
+                              false, capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(ok, *write_request_ec);
+  ASSERT_TRUE(accept_request_ec);
+  EXPECT_EQ(ok, *accept_request_ec);
+  EXPECT_FALSE(accept_request_fin);
+  EXPECT_EQ(2, received.size());
+
+  auto buffer = std::array<char, 16>{};
+  std::optional<error_code> read_ec;
+  size_t read_bytes = 0;
+  sstream.async_read_some(boost::asio::buffer(buffer),
+      [&] (error_code ec, size_t bytes) { read_ec = ec; read_bytes = bytes; });
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ("1234", std::string_view(buffer.data(), read_bytes));
+}
+
+TEST_F(AcceptRequest, after_incoming)
+{
+  // the server queues the incoming stream until it's accepted
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(ok, *write_request_ec);
+
+  accept_request();
+  context.poll();
+  ASSERT_TRUE(accept_request_ec);
+  EXPECT_EQ(ok, *accept_request_ec);
+  EXPECT_TRUE(accept_request_fin);
+  EXPECT_EQ(2, received.size());
+}
+
+TEST_F(AcceptRequest, sequential_requests)
+{
+  accept_request();
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(accept_request_ec);
+  EXPECT_EQ(ok, *accept_request_ec);
+  EXPECT_EQ("GET", received.method());
+  EXPECT_EQ("/", received.path());
+
+  // the second request's headers are decoded into a reused header set, and
+  // must not include any from the first
+  h3::stream cstream2{cconn};
+  std::optional<error_code> connect_ec;
+  cconn.async_connect(cstream2, capture(connect_ec));
+  context.poll();
+  ASSERT_TRUE(connect_ec);
+  EXPECT_EQ(ok, *connect_ec);
+
+  h3::stream sstream2{sconn};
+  h3::fields received2;
+  std::optional<error_code> accept_request2_ec;
+  sconn.async_accept_request(sstream2, received2,
+      [&] (error_code ec, bool fin) { accept_request2_ec = ec; });
+
+  h3::fields request2;
+  request2.insert(":method", "POST");
+  request2.insert(":path", "/upload");
+  request2.insert("content-type", "text/plain");
+  std::optional<error_code> write_request2_ec;
+  cstream2.async_write_request(request2, boost::asio::const_buffer{}, true,
+                               capture(write_request2_ec));
+  context.poll();
+  ASSERT_TRUE(accept_request2_ec);
+  EXPECT_EQ(ok, *accept_request2_ec);
+  EXPECT_EQ(3, received2.size());
+  EXPECT_EQ(1, received2.count(":method"));
+  EXPECT_EQ("POST", received2.method());
+  EXPECT_EQ("/upload", received2.path());
+  auto content_type = received2.find(h3::field_token::content_type);
+  ASSERT_NE(received2.end(), content_type);
+  EXPECT_EQ("text/plain", content_type->value());
+}
+
+TEST(header_sets, reused)
+{
+  boost::asio::io_context context;
+  auto global = global::init_server();
+  quic::detail::engine_impl engine{context.get_executor(), nullptr, nullptr,
+                                   LSENG_SERVER | LSENG_HTTP};
+  auto first = engine.acquire_header_set(0);
+  auto second = engine.acquire_header_set(0);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(0, engine.free_header_sets.size());
+
+  engine.release_header_set(first);
+  engine.release_header_set(second);
+  EXPECT_EQ(2, engine.free_header_sets.size());
+
+  // released sets are taken from the free list instead of allocating
+  EXPECT_EQ(second, engine.acquire_header_set(1));
+  EXPECT_EQ(first, engine.acquire_header_set(0));
+  EXPECT_EQ(0, engine.free_header_sets.size());
+  engine.release_header_set(first);
+  engine.release_header_set(second);
+}
+
+TEST(header_sets, limits)
+{
+  boost::asio::io_context context;
+  auto global = global::init_server();
+  quic::detail::engine_impl engine{context.get_executor(), nullptr, nullptr,
+                                   LSENG_SERVER | LSENG_HTTP};
+  constexpr auto max_sets = quic::detail::engine_impl::max_free_header_sets;
+  constexpr auto max_buffer = quic::detail::engine_impl::max_free_header_buffer;
+
+  // sets released beyond the limit are freed
+  auto sets = std::vector<quic::detail::recv_header_set*>{};
+  for (size_t i = 0; i < max_sets + 2; i++) {
+    sets.push_back(engine.acquire_header_set(0));
+  }
+  for (auto headers : sets) {
+    engine.release_header_set(headers);
+  }
+  EXPECT_EQ(max_sets, engine.free_header_sets.size());
+
+  // oversized decode buffers are dropped on release
+  auto headers = engine.acquire_header_set(0);
+  headers->buffer.resize(max_buffer + 1);
+  engine.release_header_set(headers);
+  EXPECT_EQ(headers, engine.free_header_sets.back().get());
+  EXPECT_EQ(0, headers->buffer.capacity());
+
+  headers = engine.acquire_header_set(0);
+  headers->buffer.resize(max_buffer);
+  engine.release_header_set(headers);
+  EXPECT_EQ(max_buffer, headers->buffer.size());
+}
+
+TEST_F(AcceptRequest, close_connection)
+{
+  accept_request();
+  context.poll();
+  ASSERT_FALSE(accept_request_ec);
+
+  sconn.close();
+  context.poll();
+  ASSERT_TRUE(accept_request_ec);
+  EXPECT_NE(ok, *accept_request_ec);
+}
+
+} // namespace nexus
@@ -1,5 +1,9 @@
 #include <nexus/h3/fields.hpp>
 #include <gtest/gtest.h>
+#include <array>
+#include <cctype>
+#include <memory_resource>
+#include <string>
 
 namespace nexus::h3 {
 
@@ -100,4 +104,293 @@ TEST(fields, assign)
   EXPECT_EQ(third, upper);
 }
 
+TEST(fields, case_insensitive)
+{
+  fields f;
+  f.insert("Content-Type", "text/plain");
+  f.insert("content-type", "text/html");
+  f.insert("X-A-Very-Long-Header-Name", "1");
+
+  EXPECT_EQ(2, f.count("CONTENT-TYPE"));
+  const auto i = f.find("content-TYPE");
+  ASSERT_NE(f.end(), i);
+  EXPECT_STREQ("Content-Type: text/plain", i->c_str());
+  EXPECT_EQ(1, f.count("x-a-very-long-header-name"));
+  EXPECT_EQ(0, f.count("x-a-very-long-header-namf"));
+  EXPECT_EQ(0, f.count("content-typ"));
+  // bytes that differ by 0x20 but aren't letters don't match
+  EXPECT_EQ(0, f.count("content\rtype"));
+}
+
+TEST(fields, erase)
+{
+  fields f;
+  f.insert("shape", "square");
+  f.insert("shape", "circle");
+  f.insert("color", "blue");
+
+  // erase the first field with the name, so the index moves to the next
+  auto i = f.erase(f.begin());
+  EXPECT_STREQ("shape: circle", i->c_str());
+  EXPECT_EQ(i, f.find("shape"));
+  EXPECT_EQ(1, f.count("shape"));
+
+  i = f.erase(i);
+  EXPECT_STREQ("color: blue", i->c_str());
+  EXPECT_EQ(f.end(), f.find("shape"));
+  EXPECT_EQ(0, f.count("shape"));
+  EXPECT_EQ(i, f.find("color"));
+
+  // reinsert after erasing
+  f.insert("shape", "line");
+  EXPECT_EQ(1, f.count("shape"));
+  EXPECT_EQ(2, f.size());
+
+  f.erase(f.begin(), f.end());
+  EXPECT_EQ(0, f.size());
+  EXPECT_EQ(f.end(), f.find("color"));
+}
+
+TEST(fields, many_names)
+{
+  fields f;
+  for (int i = 0; i < 200; i++) {
+    const auto name = "header-" + std::to_string(i);
+    f.insert(name, "a");
+    f.insert(name, "b");
+  }
+  EXPECT_EQ(400, f.size());
+  // erase every other name, which shifts back entries in the index
+  for (int i = 0; i < 200; i += 2) {
+    const auto name = "header-" + std::to_string(i);
+    auto [lower, upper] = f.equal_range(name);
+    ASSERT_NE(lower, upper);
+    f.erase(lower, upper);
+  }
+  EXPECT_EQ(200, f.size());
+  for (int i = 0; i < 200; i++) {
+    const auto name = "HEADER-" + std::to_string(i);
+    EXPECT_EQ(i % 2 ? 2 : 0, f.count(name)) << name;
+  }
+  f.clear();
+  EXPECT_EQ(0, f.count("header-1"));
+}
+
+namespace {
+
+// counts the allocations it forwards to its upstream resource
+class counting_resource : public std::pmr::memory_resource {
+  std::pmr::memory_resource* upstream;
+ public:
+  size_t allocations = 0;
+  size_t deallocations = 0;
+
+  explicit counting_resource(std::pmr::memory_resource* upstream
+                                 = std::pmr::get_default_resource())
+      : upstream(upstream) {}
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    return upstream->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    ++deallocations;
+    upstream->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource& o) const noexcept override {
+    return this == &o;
+  }
+};
+
+} // anonymous namespace
+
+TEST(fields, allocator)
+{
+  counting_resource resource;
+  {
+    fields f{&resource};
+    EXPECT_EQ(&resource, f.get_allocator().resource());
+    f.insert("shape", "square");
+    f.insert("color", "blue");
+    f.assign("shape", "circle");
+    EXPECT_EQ(4, resource.allocations); // 3 fields and the name index
+    EXPECT_EQ(1, resource.deallocations);
+  }
+  EXPECT_EQ(4, resource.deallocations);
+}
+
+TEST(fields, monotonic_buffer)
+{
+  auto buffer = std::array<std::byte, 1024>{};
+  counting_resource upstream;
+  std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(),
+                                            &upstream};
+  fields f{&arena};
+  f.insert(":status", "200");
+  f.insert("content-type", "application/json");
+  f.insert("content-length", "17");
+  f.clear();
+  EXPECT_EQ(0, upstream.allocations);
+}
+
+TEST(fields, move_same_allocator)
+{
+  counting_resource resource;
+  fields f1{&resource};
+  f1.insert("shape", "square");
+  fields f2{&resource};
+  f2 = std::move(f1);
+  EXPECT_EQ(0, f1.size());
+  ASSERT_EQ(1, f2.size());
+  EXPECT_STREQ("shape: square", f2.begin()->c_str());
+  EXPECT_EQ(2, resource.allocations); // moved without copying
+}
+
+TEST(fields, move_other_allocator)
+{
+  counting_resource resource1;
+  fields f1{&resource1};
+  f1.insert("shape", "square");
+  f1.insert("color", "blue");
+  f1.insert("shape", "circle");
+
+  counting_resource resource2;
+  fields f2{&resource2};
+  f2.insert("size", "large");
+  f2 = std::move(f1);
+  EXPECT_EQ(0, f1.size());
+  EXPECT_EQ(3, resource1.deallocations);
+  EXPECT_EQ(5, resource2.allocations); // copied into f2's resource
+  EXPECT_EQ(1, resource2.deallocations);
+
+  ASSERT_EQ(3, f2.size());
+  auto i = f2.begin();
+  EXPECT_STREQ("shape: square", i->c_str());
+  ++i;
+  EXPECT_STREQ("shape: circle", i->c_str());
+  ++i;
+  EXPECT_STREQ("color: blue", i->c_str());
+
+  // the name index preserves the order of matching fields
+  auto [lower, upper] = f2.equal_range("shape");
+  ASSERT_NE(lower, upper);
+  EXPECT_STREQ("shape: square", lower->c_str());
+  EXPECT_EQ(2, f2.count("shape"));
+}
+
+TEST(fields, swap)
+{
+  counting_resource resource;
+  fields f1{&resource};
+  f1.insert("shape", "square");
+  f1.insert("color", "blue");
+  fields f2{&resource};
+  f2.insert("size", "large");
+  const auto allocations = resource.allocations;
+  f1.swap(f2);
+  EXPECT_EQ(allocations, resource.allocations); // swapped without copying
+  EXPECT_EQ(0, resource.deallocations);
+
+  ASSERT_EQ(1, f1.size());
+  EXPECT_STREQ("size: large", f1.begin()->c_str());
+  EXPECT_EQ(1, f1.count("size"));
+  EXPECT_EQ(0, f1.count("shape"));
+  ASSERT_EQ(2, f2.size());
+  EXPECT_EQ(1, f2.count("shape"));
+  EXPECT_EQ(1, f2.count("color"));
+  EXPECT_EQ(0, f2.count("size"));
+
+  // each keeps its name index after being cleared
+  f1.clear();
+  f1.insert("shape", "circle");
+  EXPECT_EQ(allocations + 1, resource.allocations);
+}
+
+TEST(fields, tokens)
+{
+  EXPECT_EQ(field_token::method, lookup_token(":method"));
+  EXPECT_EQ(field_token::content_type, lookup_token("Content-Type"));
+  EXPECT_EQ(field_token::unknown, lookup_token("x-custom"));
+  EXPECT_EQ(field_token::unknown, lookup_token(""));
+  EXPECT_EQ(":status", token_name(field_token::status));
+  EXPECT_EQ("", token_name(field_token::unknown));
+
+  // spot-check entries of the QPACK static table
+  EXPECT_EQ(field_token::authority, qpack_static_token(0));
+  EXPECT_EQ(field_token::path, qpack_static_token(1));
+  EXPECT_EQ(field_token::method, qpack_static_token(17));
+  EXPECT_EQ(field_token::status, qpack_static_token(25));
+  EXPECT_EQ(field_token::content_type, qpack_static_token(52));
+  EXPECT_EQ(field_token::accept_language, qpack_static_token(72));
+  EXPECT_EQ(field_token::x_frame_options, qpack_static_token(98));
+  EXPECT_EQ(field_token::unknown, qpack_static_token(99));
+
+  fields f;
+  EXPECT_EQ(field_token::user_agent, f.insert("User-Agent", "test")->token());
+  EXPECT_EQ(field_token::unknown, f.insert("x-custom", "1")->token());
+  EXPECT_EQ(field_token::server, f.insert(field_token::server, "n")->token());
+  EXPECT_STREQ("server: n", f.find("server")->c_str());
+  EXPECT_EQ(f.find("user-agent"), f.find(field_token::user_agent));
+  EXPECT_EQ(f.end(), f.find(field_token::date));
+}
+
+TEST(fields, lookup_all_tokens)
+{
+  for (size_t i = 0; i < detail::token_count; i++) {
+    const auto token = static_cast<field_token>(i);
+    const auto name = std::string{token_name(token)};
+    EXPECT_EQ(token, lookup_token(name)) << name;
+    auto upper = name;
+    for (auto& c : upper) {
+      c = std::toupper(static_cast<unsigned char>(c));
+    }
+    EXPECT_EQ(token, lookup_token(upper)) << upper;
+    // same length and first character, but a different name
+    auto other = name;
+    other.back() = other.back() == '#' ? '$' : '#';
+    EXPECT_EQ(field_token::unknown, lookup_token(other)) << other;
+  }
+}
+
+TEST(fields, pseudo_headers)
+{
+  fields f;
+  EXPECT_EQ("", f.method());
+  EXPECT_EQ(f.end(), f.find(field_token::method));
+
+  f.insert(":method", "GET");
+  f.insert(":scheme", "https");
+  f.insert(":authority", "example.com");
+  f.insert(":path", "/index.html");
+  EXPECT_EQ("GET", f.method());
+  EXPECT_EQ("https", f.scheme());
+  EXPECT_EQ("example.com", f.authority());
+  EXPECT_EQ("/index.html", f.path());
+  EXPECT_EQ("", f.status());
+  EXPECT_EQ(f.find(":path"), f.find(field_token::path));
+
+  // insert keeps the first, assign replaces it
+  f.insert(":path", "/other");
+  EXPECT_EQ("/index.html", f.path());
+  f.assign(":path", "/assigned");
+  EXPECT_EQ("/assigned", f.path());
+
+  // erasing the first falls back to the next of the same name
+  f.insert(":path", "/second");
+  f.erase(f.find(field_token::path));
+  EXPECT_EQ("/second", f.path());
+  f.erase(f.find(field_token::path));
+  EXPECT_EQ("", f.path());
+
+  fields f2 = std::move(f);
+  EXPECT_EQ("GET", f2.method());
+  EXPECT_EQ("", f.method());
+
+  f2.clear();
+  EXPECT_EQ("", f2.method());
+  f2.insert(field_token::status, "200");
+  EXPECT_EQ("200", f2.status());
+}
+
 } // namespace nexus::h3
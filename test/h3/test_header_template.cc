@@ -0,0 +1,79 @@
+#include <nexus/h3/header_template.hpp>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <utility>
+
+namespace nexus::h3 {
+
+TEST(header_template, static_index)
+{
+  EXPECT_EQ(25, qpack_static_index(field_token::status, "200"));
+  EXPECT_EQ(24, qpack_static_index(field_token::status, "299"));
+  EXPECT_EQ(46, qpack_static_index(field_token::content_type,
+                                   "application/json"));
+  EXPECT_EQ(92, qpack_static_index(field_token::server, "nexus"));
+  EXPECT_EQ(98, qpack_static_index(field_token::x_frame_options,
+                                   "sameorigin"));
+  EXPECT_EQ(-1, qpack_static_index(field_token::unknown, ""));
+}
+
+TEST(header_template, empty)
+{
+  const auto t = header_template{fields{}};
+  EXPECT_EQ(0, t.size());
+  EXPECT_EQ(t.pseudo_begin(), t.pseudo_end());
+  EXPECT_EQ(t.regular_begin(), t.regular_end());
+}
+
+TEST(header_template, entries)
+{
+  fields f;
+  f.insert("content-type", "application/json");
+  f.insert(":status", "200");
+  f.insert("x-custom", "1");
+  f.insert("Cache-Control", "no-store", true);
+  const auto t = header_template{f};
+  ASSERT_EQ(4, t.size());
+  EXPECT_EQ(4, t.fields().size());
+
+  // pseudo-headers are moved to the front
+  ASSERT_EQ(1, std::distance(t.pseudo_begin(), t.pseudo_end()));
+  EXPECT_STREQ(":status: 200", t.pseudo_begin()->f->c_str());
+  EXPECT_EQ(25, t.pseudo_begin()->qpack_index);
+
+  ASSERT_EQ(3, std::distance(t.regular_begin(), t.regular_end()));
+  auto e = t.regular_begin();
+  EXPECT_STREQ("content-type: application/json", e->f->c_str());
+  EXPECT_EQ(46, e->qpack_index);
+  ++e;
+  EXPECT_STREQ("x-custom: 1", e->f->c_str());
+  EXPECT_EQ(-1, e->qpack_index);
+  ++e;
+  EXPECT_STREQ("Cache-Control: no-store", e->f->c_str());
+  EXPECT_EQ(40, e->qpack_index);
+  EXPECT_TRUE(e->f->never_index());
+}
+
+TEST(header_template, move)
+{
+  fields f;
+  f.insert(":status", "200");
+  f.insert("server", "nexus");
+  auto t1 = header_template{f};
+  const auto status = t1.pseudo_begin()->f;
+
+  // the moved template refers to the same fields
+  auto t2 = header_template{std::move(t1)};
+  ASSERT_EQ(2, t2.size());
+  EXPECT_EQ(status, t2.pseudo_begin()->f);
+  EXPECT_STREQ("server: nexus", t2.regular_begin()->f->c_str());
+  EXPECT_EQ(0, t1.size());
+  EXPECT_EQ(t1.pseudo_begin(), t1.pseudo_end());
+
+  t1 = std::move(t2);
+  ASSERT_EQ(2, t1.size());
+  EXPECT_EQ(status, t1.pseudo_begin()->f);
+  EXPECT_EQ(92, t1.regular_begin()->qpack_index);
+}
+
+} // namespace nexus::h3
@@ -0,0 +1,109 @@
+#include <nexus/h3/sharded_server.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <nexus/ssl.hpp>
+#include <nexus/h3/client.hpp>
+#include <nexus/h3/stream.hpp>
+#include <nexus/global_init.hpp>
+
+#include "certificate.hpp"
+
+namespace nexus {
+
+namespace {
+
+static constexpr const char* alpn = "\02h3";
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out,
+             std::unique_ptr<h3::server_connection>& conn) {
+  return [&] (error_code ec, std::unique_ptr<h3::server_connection> c) {
+    out = ec;
+    conn = std::move(c);
+  };
+}
+
+// the shards run on their own threads, so wait for a completion
+template <typename Predicate>
+void run_until(boost::asio::io_context& context, Predicate&& pred) {
+  while (!pred() && context.run_one_for(std::chrono::seconds(5))) {}
+}
+
+} // anonymous namespace
+
+TEST(h3_sharded_server, accept)
+{
+  auto context = boost::asio::io_context{};
+  auto ex = context.get_executor();
+  auto global = global::init_client_server();
+
+  auto ssl = test::init_server_context(alpn);
+  auto sslc = test::init_client_context(alpn);
+
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  // uses default_server_settings()
+  auto server = h3::sharded_server{ex, udp::endpoint{localhost, 0}, ssl, 2};
+  EXPECT_EQ(2u, server.size());
+  const auto endpoint = server.local_endpoint();
+  server.listen(16);
+
+  std::optional<error_code> accept_ec;
+  std::unique_ptr<h3::server_connection> sconn;
+  server.async_accept(capture(accept_ec, sconn));
+
+  auto client = h3::client{ex, udp::endpoint{}, sslc};
+  auto cconn = h3::client_connection{client, endpoint, "host"};
+
+  std::optional<error_code> stream_connect_ec;
+  auto cstream = h3::stream{cconn};
+  cconn.async_connect(cstream, [&] (error_code ec) { stream_connect_ec = ec; });
+
+  run_until(context, [&] { return accept_ec.has_value(); });
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(ok, *accept_ec);
+  ASSERT_TRUE(sconn);
+  EXPECT_TRUE(sconn->is_open());
+  // the connection id names the shard that accepted it
+  const auto id = sconn->id();
+  ASSERT_LT(0, id.size());
+  EXPECT_GT(server.size(), id[0]);
+
+  // claimed connections are destroyed before the server
+  sconn.reset();
+  cconn.close();
+  server.close();
+}
+
+TEST(h3_sharded_server, close_aborts_accept)
+{
+  auto context = boost::asio::io_context{};
+  auto ex = context.get_executor();
+  auto global = global::init_client_server();
+
+  auto ssl = test::init_server_context(alpn);
+
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto server = h3::sharded_server{ex, udp::endpoint{localhost, 0}, ssl,
+                                   quic::default_server_settings(), 2};
+  server.listen(16);
+  EXPECT_THROW(server.listen(16), system_error);
+
+  std::optional<error_code> accept_ec;
+  std::unique_ptr<h3::server_connection> sconn;
+  server.async_accept(capture(accept_ec, sconn));
+
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+  EXPECT_FALSE(accept_ec);
+
+  server.close();
+  context.poll();
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(quic::connection_error::aborted, *accept_ec);
+  EXPECT_FALSE(sconn);
+}
+
+} // namespace nexus
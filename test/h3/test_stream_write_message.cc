@@ -0,0 +1,318 @@
+#include <nexus/h3/server.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <nexus/h3/client.hpp>
+#include <nexus/h3/stream.hpp>
+#include <nexus/global_init.hpp>
+
+#include "certificate.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& ec) {
+  return [&] (error_code e, size_t = 0) { ec = e; };
+}
+
+} // anonymous namespace
+
+class WriteMessage : public testing::Test {
+ public:
+  static constexpr const char* alpn = "\02h3";
+
+  boost::asio::io_context context;
+  global::context global = global::init_client_server();
+
+  ssl::context ssl = test::init_server_context(alpn);
+  ssl::context sslc = test::init_client_context(alpn);
+
+  h3::server server{context.get_executor()};
+  boost::asio::ip::address localhost = boost::asio::ip::make_address("127.0.0.1");
+  h3::acceptor acceptor{server, udp::endpoint{localhost, 0}, ssl};
+  h3::server_connection sconn{acceptor};
+  h3::stream sstream{sconn};
+
+  h3::client client{context.get_executor(), udp::endpoint{}, sslc};
+  h3::client_connection cconn{client, acceptor.local_endpoint(), "host"};
+  h3::stream cstream{cconn};
+
+  void SetUp() override
+  {
+    acceptor.listen(16);
+
+    std::optional<error_code> cstream_connect_ec;
+    cconn.async_connect(cstream, capture(cstream_connect_ec));
+
+    std::optional<error_code> accept_ec;
+    acceptor.async_accept(sconn, capture(accept_ec));
+
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(cstream_connect_ec);
+    EXPECT_EQ(ok, *cstream_connect_ec);
+    ASSERT_TRUE(accept_ec);
+    EXPECT_EQ(ok, *accept_ec);
+  }
+
+  // read the rest of the stream's body
+  std::string read_body(h3::stream& stream)
+  {
+    std::string body;
+    auto buffer = std::array<char, 4096>{};
+    for (;;) {
+      std::optional<error_code> ec;
+      size_t bytes = 0;
+      stream.async_read_some(boost::asio::buffer(buffer),
+          [&] (error_code e, size_t n) { ec = e; bytes = n; });
+      while (!ec && context.poll()) {}
+      if (!ec || *ec || bytes == 0) {
+        break;
+      }
+      body.append(buffer.data(), bytes);
+    }
+    return body;
+  }
+};
+
+TEST_F(WriteMessage, request_and_response)
+{
+  std::optional<error_code> sstream_accept_ec;
+  sconn.async_accept(sstream, capture(sstream_accept_ec));
+
+  auto request = h3::fields{};
+  request.insert(":method", "POST");
+  request.insert(":path", "/");
+  const auto request_body = std::string_view{"{\"salad\":\"potato\"}"};
+  std::optional<error_code> write_request_ec;
+  size_t write_request_bytes = 0;
+  cstream.async_write_request(request, boost::asio::buffer(request_body), true,
+      [&] (error_code ec, size_t bytes) {
+        write_request_ec = ec;
+        write_request_bytes = bytes;
+      });
+
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(ok, *write_request_ec);
+  EXPECT_EQ(request_body.size(), write_request_bytes);
+  ASSERT_TRUE(sstream_accept_ec);
+  EXPECT_EQ(ok, *sstream_accept_ec);
+
+  auto received_request = h3::fields{};
+  std::optional<error_code> read_request_ec;
+  sstream.async_read_headers(received_request, capture(read_request_ec));
+  context.poll();
+  ASSERT_TRUE(read_request_ec);
+  EXPECT_EQ(ok, *read_request_ec);
+  EXPECT_EQ(2, received_request.size());
+  EXPECT_EQ(request_body, read_body(sstream));
+
+  // response with no body sends the fin with the headers
+  auto response = h3::fields{};
+  response.insert(":status", "204");
+  std::optional<error_code> write_response_ec;
+  sstream.async_write_response(response, boost::asio::const_buffer{}, true,
+                               capture(write_response_ec));
+
+  auto received_response = h3::fields{};
+  std::optional<error_code> read_response_ec;
+  cstream.async_read_headers(received_response, capture(read_response_ec));
+  context.poll();
+  ASSERT_TRUE(write_response_ec);
+  EXPECT_EQ(ok, *write_response_ec);
+  ASSERT_TRUE(read_response_ec);
+  EXPECT_EQ(ok, *read_response_ec);
+  ASSERT_EQ(1, received_response.size());
+  EXPECT_EQ("", read_body(cstream));
+
+  // the stream was shut down for writes
+  std::optional<error_code> write_ec;
+  sstream.async_write_some(boost::asio::buffer(std::string_view{"x"}),
+                           capture(write_ec));
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(make_error_code(errc::bad_file_descriptor), *write_ec);
+}
+
+TEST_F(WriteMessage, response_without_fin)
+{
+  std::optional<error_code> sstream_accept_ec;
+  sconn.async_accept(sstream, capture(sstream_accept_ec));
+
+  auto request = h3::fields{};
+  request.insert(":method", "GET");
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(ok, *write_request_ec);
+  ASSERT_TRUE(sstream_accept_ec);
+  EXPECT_EQ(ok, *sstream_accept_ec);
+
+  auto received_request = h3::fields{};
+  std::optional<error_code> read_request_ec;
+  sstream.async_read_headers(received_request, capture(read_request_ec));
+  context.poll();
+  ASSERT_TRUE(read_request_ec);
+  EXPECT_EQ(ok, *read_request_ec);
+
+  // write headers and the start of the body, then the rest separately
+  auto response = h3::fields{};
+  response.insert(":status", "200");
+  std::optional<error_code> write_response_ec;
+  sstream.async_write_response(response,
+                               boost::asio::buffer(std::string_view{"12"}),
+                               false, capture(write_response_ec));
+  context.poll();
+  ASSERT_TRUE(write_response_ec);
+  EXPECT_EQ(ok, *write_response_ec);
+
+  std::optional<error_code> write_last_ec;
+  sstream.async_write_last(boost::asio::buffer(std::string_view{"34"}),
+                           capture(write_last_ec));
+
+  auto received_response = h3::fields{};
+  std::optional<error_code> read_response_ec;
+  cstream.async_read_headers(received_response, capture(read_response_ec));
+  context.poll();
+  ASSERT_TRUE(write_last_ec);
+  EXPECT_EQ(ok, *write_last_ec);
+  ASSERT_TRUE(read_response_ec);
+  EXPECT_EQ(ok, *read_response_ec);
+  EXPECT_EQ("1234", read_body(cstream));
+}
+
+TEST_F(WriteMessage, response_template)
+{
+  std::optional<error_code> sstream_accept_ec;
+  sconn.async_accept(sstream, capture(sstream_accept_ec));
+
+  auto request = h3::fields{};
+  request.insert(":method", "GET");
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(sstream_accept_ec);
+  EXPECT_EQ(ok, *sstream_accept_ec);
+
+  auto received_request = h3::fields{};
+  std::optional<error_code> read_request_ec;
+  sstream.async_read_headers(received_request, capture(read_request_ec));
+  context.poll();
+  ASSERT_TRUE(read_request_ec);
+  EXPECT_EQ(ok, *read_request_ec);
+
+  auto shared = h3::fields{};
+  shared.insert("content-type", "application/json");
+  shared.insert("server", "nexus");
+  shared.insert(":status", "200");
+  const auto tmpl = h3::header_template{shared};
+
+  auto response = h3::fields{};
+  response.insert("content-length", "2");
+  std::optional<error_code> write_response_ec;
+  sstream.async_write_response(tmpl, response,
+                               boost::asio::buffer(std::string_view{"{}"}),
+                               true, capture(write_response_ec));
+
+  auto received_response = h3::fields{};
+  std::optional<error_code> read_response_ec;
+  cstream.async_read_headers(received_response, capture(read_response_ec));
+  context.poll();
+  ASSERT_TRUE(write_response_ec);
+  EXPECT_EQ(ok, *write_response_ec);
+  ASSERT_TRUE(read_response_ec);
+  EXPECT_EQ(ok, *read_response_ec);
+  ASSERT_EQ(4, received_response.size());
+  EXPECT_EQ("200", received_response.status());
+  auto i = received_response.begin();
+  EXPECT_STREQ(":status: 200", i->c_str()); // pseudo-headers come first
+  ++i;
+  EXPECT_STREQ("content-length: 2", i->c_str());
+  ++i;
+  EXPECT_STREQ("content-type: application/json", i->c_str());
+  ++i;
+  EXPECT_STREQ("server: nexus", i->c_str());
+  EXPECT_EQ("{}", read_body(cstream));
+}
+
+TEST_F(WriteMessage, response_template_override)
+{
+  std::optional<error_code> sstream_accept_ec;
+  sconn.async_accept(sstream, capture(sstream_accept_ec));
+
+  auto request = h3::fields{};
+  request.insert(":method", "GET");
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(sstream_accept_ec);
+  EXPECT_EQ(ok, *sstream_accept_ec);
+
+  auto received_request = h3::fields{};
+  std::optional<error_code> read_request_ec;
+  sstream.async_read_headers(received_request, capture(read_request_ec));
+  context.poll();
+  ASSERT_TRUE(read_request_ec);
+  EXPECT_EQ(ok, *read_request_ec);
+
+  auto shared = h3::fields{};
+  shared.insert(":status", "200");
+  shared.insert("content-type", "application/json");
+  shared.insert("server", "nexus");
+  const auto tmpl = h3::header_template{shared};
+
+  // the response's fields replace the template's fields of the same name
+  auto response = h3::fields{};
+  response.insert(":status", "404");
+  response.insert("Content-Type", "text/plain");
+  std::optional<error_code> write_response_ec;
+  sstream.async_write_response(tmpl, response, boost::asio::const_buffer{},
+                               true, capture(write_response_ec));
+
+  auto received_response = h3::fields{};
+  std::optional<error_code> read_response_ec;
+  cstream.async_read_headers(received_response, capture(read_response_ec));
+  context.poll();
+  ASSERT_TRUE(write_response_ec);
+  EXPECT_EQ(ok, *write_response_ec);
+  ASSERT_TRUE(read_response_ec);
+  EXPECT_EQ(ok, *read_response_ec);
+  ASSERT_EQ(3, received_response.size());
+  EXPECT_EQ("404", received_response.status());
+  EXPECT_EQ(1, received_response.count(":status"));
+  EXPECT_EQ(1, received_response.count("content-type"));
+  EXPECT_EQ("text/plain", received_response.find("content-type")->value());
+  EXPECT_EQ("nexus", received_response.find("server")->value());
+}
+
+TEST_F(WriteMessage, after_headers)
+{
+  auto request = h3::fields{};
+  request.insert(":method", "GET");
+  std::optional<error_code> write_headers_ec;
+  cstream.async_write_headers(request, capture(write_headers_ec));
+  context.poll();
+  ASSERT_TRUE(write_headers_ec);
+  EXPECT_EQ(ok, *write_headers_ec);
+
+  // headers were already written
+  std::optional<error_code> write_request_ec;
+  cstream.async_write_request(request, boost::asio::const_buffer{}, true,
+                              capture(write_request_ec));
+  context.poll();
+  ASSERT_TRUE(write_request_ec);
+  EXPECT_EQ(make_error_code(errc::invalid_argument), *write_request_ec);
+}
+
+} // namespace nexus
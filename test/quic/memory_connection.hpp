@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <gtest/gtest.h>
+#include <nexus/quic/client.hpp>
+#include <nexus/quic/connection.hpp>
+#include <nexus/quic/memory_network.hpp>
+#include <nexus/quic/server.hpp>
+#include <nexus/quic/stream.hpp>
+#include <nexus/global_init.hpp>
+
+#include "certificate.hpp"
+
+namespace nexus::test {
+
+// a client connection to a server over a memory network, with a stream that
+// the client opened
+struct memory_connection {
+  quic::server server;
+  quic::acceptor acceptor;
+  quic::connection sconn;
+  quic::stream sstream;
+  quic::client client;
+  quic::connection cconn;
+  quic::stream cstream;
+  std::optional<error_code> accept_ec;
+  std::optional<error_code> stream_connect_ec;
+
+  memory_connection(const boost::asio::any_io_executor& ex,
+                    quic::memory_network& network,
+                    ssl::context& ssl, ssl::context& sslc,
+                    const quic::settings& ssettings,
+                    const quic::settings& csettings)
+    : server(ex, ssettings),
+      acceptor(server, network, udp::endpoint{
+                 boost::asio::ip::make_address("127.0.0.1"), 0}, ssl),
+      sconn(acceptor),
+      sstream(sconn),
+      client(ex, network, udp::endpoint{}, sslc, csettings),
+      cconn(client, acceptor.local_endpoint(), "host"),
+      cstream(cconn)
+  {
+    acceptor.listen(16);
+    acceptor.async_accept(sconn, [this] (error_code ec) { accept_ec = ec; });
+    cconn.async_connect(cstream,
+        [this] (error_code ec) { stream_connect_ec = ec; });
+  }
+};
+
+// tests that run a client and server over a quic::memory_network
+class MemoryNetwork : public testing::Test {
+ protected:
+  boost::asio::io_context context;
+  global::context global = global::init_client_server();
+  ssl::context ssl = init_server_context("\04test");
+  ssl::context sslc = init_client_context("\04test");
+  quic::memory_network network;
+  std::optional<memory_connection> conn;
+
+  // connect a client to a server with the given settings, and wait for the
+  // server to accept it and for the client's stream to open
+  void connect(const quic::settings& ssettings =
+                   quic::default_server_settings(),
+               const quic::settings& csettings =
+                   quic::default_client_settings())
+  {
+    conn.emplace(context.get_executor(), network, ssl, sslc,
+                 ssettings, csettings);
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(conn->accept_ec);
+    EXPECT_EQ(error_code{}, *conn->accept_ec);
+    ASSERT_TRUE(conn->stream_connect_ec);
+    EXPECT_EQ(error_code{}, *conn->stream_connect_ec);
+  }
+
+  // accept the client's stream on the server. the server only learns of the
+  // stream once the client writes to it
+  void accept_stream()
+  {
+    std::optional<error_code> ec;
+    conn->sconn.async_accept(conn->sstream, [&] (error_code e) { ec = e; });
+    context.poll();
+    ASSERT_TRUE(ec);
+    EXPECT_EQ(error_code{}, *ec);
+  }
+
+  // read from the stream until the end, or until nothing happens
+  void read_all(quic::stream& stream, std::string& received)
+  {
+    auto buffer = std::array<char, 16384>{};
+    for (;;) {
+      std::optional<error_code> ec;
+      size_t bytes = 0;
+      stream.async_read_some(boost::asio::buffer(buffer),
+          [&] (error_code e, size_t n) { ec = e; bytes = n; });
+      while (!ec && context.poll()) {}
+      ASSERT_TRUE(ec);
+      ASSERT_EQ(error_code{}, *ec);
+      if (bytes == 0) {
+        break;
+      }
+      received.append(buffer.data(), bytes);
+    }
+  }
+};
+
+} // namespace nexus::test
@@ -0,0 +1,247 @@
+#include <nexus/quic/memory_network.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <nexus/quic/client.hpp>
+#include <nexus/quic/connection.hpp>
+#include <nexus/quic/server.hpp>
+#include <nexus/quic/stream.hpp>
+#include <nexus/quic/detail/engine_impl.hpp>
+#include <nexus/global_init.hpp>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out) {
+  return [&] (error_code ec, size_t bytes = 0) { out = ec; };
+}
+
+} // anonymous namespace
+
+using test::MemoryNetwork;
+
+TEST_F(MemoryNetwork, bind)
+{
+  auto server = quic::server{context.get_executor()};
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+
+  // port 0 is assigned an unused port
+  auto acceptor1 = quic::acceptor{server, network,
+                                  udp::endpoint{localhost, 0}, ssl};
+  const auto endpoint = acceptor1.local_endpoint();
+  EXPECT_EQ(localhost, endpoint.address());
+  EXPECT_NE(0, endpoint.port());
+
+  // binding the same endpoint again fails
+  EXPECT_THROW(quic::acceptor(server, network, endpoint, ssl), system_error);
+
+  // the endpoint can be bound again after close
+  acceptor1.close();
+  auto acceptor2 = quic::acceptor{server, network, endpoint, ssl};
+  EXPECT_EQ(endpoint, acceptor2.local_endpoint());
+}
+
+TEST_F(MemoryNetwork, connect_stream)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+  {
+    const auto data = std::string_view{"1234"};
+    std::optional<error_code> cstream_write_ec;
+    conn->cstream.async_write_some(boost::asio::buffer(data),
+                                   capture(cstream_write_ec));
+    conn->cstream.shutdown(1);
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(cstream_write_ec);
+    EXPECT_EQ(ok, *cstream_write_ec);
+  }
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  {
+    auto data = std::array<char, 5>{};
+    std::optional<error_code> sstream_read_ec;
+    conn->sstream.async_read_some(boost::asio::buffer(data),
+                                  capture(sstream_read_ec));
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(sstream_read_ec);
+    EXPECT_EQ(ok, *sstream_read_ec);
+    EXPECT_STREQ(data.data(), "1234");
+  }
+
+  // every packet sent was received by the other side
+  const auto sstats = conn->acceptor.stats();
+  const auto cstats = conn->client.stats();
+  EXPECT_EQ(cstats.packets_sent, sstats.packets_received);
+  EXPECT_EQ(sstats.packets_sent, cstats.packets_received);
+}
+
+// settings for a client and server that defer processing, or don't
+static quic::settings deferred_settings(quic::settings s, bool deferred)
+{
+  s.deferred_processing = deferred;
+  return s;
+}
+
+class DeferredProcessing : public MemoryNetwork {
+ protected:
+  static constexpr size_t num_streams = 8;
+
+  // connect with the given deferred_processing setting, then write to
+  // several streams in one turn of the event loop. returns the number of
+  // packets the client sent for those writes
+  void write_streams(bool deferred, uint64_t& packets)
+  {
+    ASSERT_NO_FATAL_FAILURE(connect(
+        deferred_settings(quic::default_server_settings(), deferred),
+        deferred_settings(quic::default_client_settings(), deferred)));
+    auto& client = conn->client;
+
+    auto cstreams = std::deque<quic::stream>{}; // streams aren't movable
+    auto cstream_connect_ecs =
+        std::array<std::optional<error_code>, num_streams>{};
+    for (size_t i = 0; i < num_streams; i++) {
+      auto& cstream = cstreams.emplace_back(conn->cconn);
+      conn->cconn.async_connect(cstream, capture(cstream_connect_ecs[i]));
+    }
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    for (auto& ec : cstream_connect_ecs) {
+      ASSERT_TRUE(ec);
+      EXPECT_EQ(ok, *ec);
+    }
+
+    const auto data = std::string_view{"1234"};
+    const auto packets_sent = client.stats().packets_sent;
+    auto cstream_write_ecs =
+        std::array<std::optional<error_code>, num_streams>{};
+    for (size_t i = 0; i < num_streams; i++) {
+      cstreams[i].async_write_some(boost::asio::buffer(data),
+                                   capture(cstream_write_ecs[i]));
+      cstreams[i].shutdown(1);
+    }
+    if (deferred) {
+      // writes are only processed on the next turn of the event loop
+      EXPECT_EQ(packets_sent, client.stats().packets_sent);
+    }
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    packets = client.stats().packets_sent - packets_sent;
+    for (auto& ec : cstream_write_ecs) {
+      ASSERT_TRUE(ec);
+      EXPECT_EQ(ok, *ec);
+    }
+
+    // the server receives each stream's data
+    for (size_t i = 0; i < num_streams; i++) {
+      std::optional<error_code> sstream_accept_ec;
+      auto sstream = quic::stream{conn->sconn};
+      conn->sconn.async_accept(sstream, capture(sstream_accept_ec));
+      context.poll();
+      ASSERT_TRUE(sstream_accept_ec);
+      EXPECT_EQ(ok, *sstream_accept_ec);
+
+      auto buffer = std::array<char, 5>{};
+      std::optional<error_code> sstream_read_ec;
+      sstream.async_read_some(boost::asio::buffer(buffer),
+                              capture(sstream_read_ec));
+      context.poll();
+      ASSERT_TRUE(sstream_read_ec);
+      EXPECT_EQ(ok, *sstream_read_ec);
+      EXPECT_STREQ(buffer.data(), "1234");
+    }
+  }
+};
+
+TEST_F(DeferredProcessing, coalesce_writes)
+{
+  uint64_t immediate_packets = 0;
+  ASSERT_NO_FATAL_FAILURE(write_streams(false, immediate_packets));
+  uint64_t deferred_packets = 0;
+  ASSERT_NO_FATAL_FAILURE(write_streams(true, deferred_packets));
+
+  // processing each stream's write separately sends its own packets, but
+  // deferred writes share the packets of a single pass
+  EXPECT_LT(0, deferred_packets);
+  EXPECT_LT(deferred_packets, immediate_packets);
+}
+
+TEST_F(DeferredProcessing, destroy)
+{
+  ASSERT_NO_FATAL_FAILURE(connect(
+      deferred_settings(quic::default_server_settings(), true),
+      deferred_settings(quic::default_client_settings(), true)));
+  {
+    auto cconn = quic::connection{conn->client, conn->acceptor.local_endpoint(),
+                                  "host"};
+    std::optional<error_code> connect_ec;
+    auto cstream = quic::stream{cconn};
+    cconn.async_connect(cstream, capture(connect_ec));
+    context.poll();
+    ASSERT_TRUE(connect_ec);
+    EXPECT_EQ(ok, *connect_ec);
+    EXPECT_TRUE(cstream.is_open());
+    EXPECT_TRUE(cconn.is_open());
+    // destroy the open stream and connection
+  }
+  // lsquic must not call back into the destroyed stream or connection
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+}
+
+TEST(engine_mutex, disable)
+{
+  auto mutex = quic::detail::engine_mutex{};
+  bool locked = true;
+  {
+    // another thread can't take the mutex while it's held
+    auto lock = std::unique_lock{mutex};
+    std::thread([&] { locked = mutex.try_lock(); }).join();
+    EXPECT_FALSE(locked);
+  }
+  // once disabled, locking does nothing
+  mutex.disable();
+  auto lock = std::unique_lock{mutex};
+  std::thread([&] {
+        locked = mutex.try_lock();
+        if (locked) {
+          mutex.unlock();
+        }
+      }).join();
+  EXPECT_TRUE(locked);
+}
+
+TEST_F(MemoryNetwork, single_threaded)
+{
+  auto settings = quic::default_server_settings();
+  settings.single_threaded = true;
+  auto csettings = quic::default_client_settings();
+  csettings.single_threaded = true;
+  ASSERT_NO_FATAL_FAILURE(connect(settings, csettings));
+  EXPECT_TRUE(conn->cconn.is_open());
+  EXPECT_TRUE(conn->cstream.is_open());
+
+  // the synchronous functions would wait for another thread to process the
+  // engine, so the stream is only used through the asynchronous ones
+  std::optional<error_code> write_ec;
+  conn->cstream.async_write_some(boost::asio::buffer(std::string_view{"1234"}),
+                                 capture(write_ec));
+  conn->cstream.shutdown(1);
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  std::string received;
+  ASSERT_NO_FATAL_FAILURE(read_all(conn->sstream, received));
+  EXPECT_EQ("1234", received);
+}
+
+} // namespace nexus
@@ -1,6 +1,9 @@
 #include <nexus/quic/server.hpp>
 #include <gtest/gtest.h>
+#include <array>
+#include <chrono>
 #include <optional>
+#include <vector>
 #include <lsquic.h>
 #include <nexus/ssl.hpp>
 #include <nexus/quic/client.hpp>
@@ -94,4 +97,331 @@ TEST(server, accept_ready) // accept() after a connection is received
   EXPECT_EQ(ok, *accept_ec);
 }
 
+// a client connection to a server over loopback
+struct loopback_connection {
+  quic::server server;
+  quic::acceptor acceptor;
+  quic::connection sconn;
+  quic::client client;
+  quic::connection cconn;
+  quic::stream cstream;
+  std::optional<error_code> accept_ec;
+  std::optional<error_code> stream_connect_ec;
+
+  loopback_connection(const boost::asio::any_io_executor& ex,
+                      ssl::context& ssl, ssl::context& sslc,
+                      const quic::settings& ssettings,
+                      const quic::settings& csettings,
+                      quic::packet_io io)
+    : server(ex, ssettings),
+      acceptor(server, udp::endpoint{
+                 boost::asio::ip::make_address("127.0.0.1"), 0}, ssl, io),
+      sconn(acceptor),
+      client(ex, udp::endpoint{}, sslc, csettings, io),
+      cconn(client, acceptor.local_endpoint(), "host"),
+      cstream(cconn)
+  {
+    acceptor.listen(16);
+    acceptor.async_accept(sconn, capture(accept_ec));
+    cconn.async_connect(cstream, capture(stream_connect_ec));
+  }
+};
+
+// tests for the settings that control a socket's packet i/o
+class ServerTransport : public testing::Test {
+ protected:
+  boost::asio::io_context context;
+  global::context global = global::init_client_server();
+  ssl::context ssl = test::init_server_context("\04test");
+  ssl::context sslc = test::init_client_context("\04test");
+  std::optional<loopback_connection> conn;
+
+  // connect a client to a server with the given settings, and wait for the
+  // server to accept it
+  void connect(const quic::settings& ssettings,
+               const quic::settings& csettings =
+                   quic::default_client_settings(),
+               quic::packet_io io = quic::packet_io::reactor)
+  {
+    conn.emplace(context.get_executor(), ssl, sslc, ssettings, csettings, io);
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(conn->accept_ec);
+    EXPECT_EQ(ok, *conn->accept_ec);
+  }
+
+  // run until the given completion, or until nothing happens for a while
+  void run_until(const std::optional<error_code>& ec)
+  {
+    while (!ec && context.run_one_for(std::chrono::seconds(5))) {}
+  }
+
+  // send 'size' bytes from the client to the server over a stream, so the
+  // client sends trains of full-size packets
+  void bulk_transfer(size_t size)
+  {
+    const auto data = std::vector<char>(size, 'x');
+    std::optional<error_code> write_ec;
+    conn->cstream.async_write_last(boost::asio::buffer(data),
+        [&] (error_code ec, size_t) { write_ec = ec; });
+
+    std::optional<error_code> sstream_accept_ec;
+    auto sstream = quic::stream{conn->sconn};
+    conn->sconn.async_accept(sstream, capture(sstream_accept_ec));
+    run_until(sstream_accept_ec);
+    ASSERT_TRUE(sstream_accept_ec);
+    ASSERT_EQ(ok, *sstream_accept_ec);
+
+    auto buffer = std::array<char, 65536>{};
+    size_t received = 0;
+    while (received < size) {
+      std::optional<error_code> read_ec;
+      size_t bytes = 0;
+      sstream.async_read_some(boost::asio::buffer(buffer),
+          [&] (error_code ec, size_t n) { read_ec = ec; bytes = n; });
+      run_until(read_ec);
+      ASSERT_TRUE(read_ec);
+      ASSERT_EQ(ok, *read_ec);
+      received += bytes;
+    }
+    run_until(write_ec);
+    ASSERT_TRUE(write_ec);
+    EXPECT_EQ(ok, *write_ec);
+  }
+};
+
+TEST_F(ServerTransport, receive_batch)
+{
+  auto settings = quic::default_server_settings();
+  settings.receive_batch_size = 0;
+  EXPECT_FALSE(quic::check_server_settings(settings, nullptr));
+  EXPECT_THROW(quic::server(context.get_executor(), settings),
+               quic::bad_setting);
+
+  settings.receive_batch_size = 1;
+  ASSERT_TRUE(quic::check_server_settings(settings, nullptr));
+  ASSERT_NO_FATAL_FAILURE(connect(settings));
+
+  // one packet per recvmmsg() call with receive_batch_size=1
+  const auto sstats = conn->acceptor.stats();
+  EXPECT_LT(0, sstats.receive_calls);
+  EXPECT_EQ(sstats.receive_calls, sstats.packets_received);
+
+  const auto cstats = conn->client.stats();
+  EXPECT_LT(0, cstats.receive_calls);
+  EXPECT_LE(cstats.receive_calls, cstats.packets_received);
+
+  // sendmmsg() sends one or more packets per call
+  EXPECT_LT(0, sstats.send_calls);
+  EXPECT_LE(sstats.send_calls, sstats.packets_sent);
+  EXPECT_LT(0, cstats.send_calls);
+  EXPECT_LE(cstats.send_calls, cstats.packets_sent);
+}
+
+TEST_F(ServerTransport, receive_budget)
+{
+  auto settings = quic::default_server_settings();
+  settings.receive_budget = 0;
+  EXPECT_FALSE(quic::check_server_settings(settings, nullptr));
+  EXPECT_THROW(quic::server(context.get_executor(), settings),
+               quic::bad_setting);
+
+  // yield after every packet, and bound each processing pass
+  settings.receive_batch_size = 1;
+  settings.receive_budget = 1;
+  settings.processing_time_threshold = std::chrono::microseconds(100);
+  settings.read_write_once = true;
+  ASSERT_TRUE(quic::check_server_settings(settings, nullptr));
+  ASSERT_NO_FATAL_FAILURE(connect(settings));
+  ASSERT_NO_FATAL_FAILURE(bulk_transfer(1 << 20));
+
+  // every recvmmsg() call that returned a packet used up the budget, so the
+  // socket yielded to the executor before each read instead of draining the
+  // flood of packets in one handler
+  const auto sstats = conn->acceptor.stats();
+  EXPECT_LT(0, sstats.receive_calls);
+  EXPECT_EQ(sstats.receive_calls, sstats.receive_yields);
+
+  // with the default budget of 256 packets in batches of 32, the socket
+  // reads at least 8 batches before each yield
+  const auto cstats = conn->client.stats();
+  EXPECT_LT(0, cstats.receive_calls);
+  EXPECT_LE(cstats.receive_yields * 8, cstats.receive_calls);
+}
+
+TEST_F(ServerTransport, generic_segmentation_offload)
+{
+  auto settings = quic::default_server_settings();
+  settings.generic_segmentation_offload = true;
+  auto csettings = quic::default_client_settings();
+  csettings.generic_segmentation_offload = true;
+  ASSERT_NO_FATAL_FAILURE(connect(settings, csettings));
+  if (!conn->client.features().generic_segmentation_offload) {
+    GTEST_SKIP() << "kernel doesn't support UDP_SEGMENT";
+  }
+
+  ASSERT_NO_FATAL_FAILURE(bulk_transfer(1 << 20));
+
+  // the client sent trains of same-size packets in segmented messages
+  const auto cstats = conn->client.stats();
+  EXPECT_LT(0, cstats.segmented_sends);
+  EXPECT_LT(cstats.send_calls, cstats.packets_sent);
+}
+
+TEST_F(ServerTransport, generic_receive_offload)
+{
+  auto settings = quic::default_server_settings();
+  settings.generic_segmentation_offload = true;
+  settings.generic_receive_offload = true;
+  auto csettings = quic::default_client_settings();
+  csettings.generic_segmentation_offload = true;
+  csettings.generic_receive_offload = true;
+  ASSERT_NO_FATAL_FAILURE(connect(settings, csettings));
+  // over loopback, packets are only coalesced if they were sent segmented
+  if (!conn->acceptor.features().generic_receive_offload ||
+      !conn->client.features().generic_segmentation_offload) {
+    GTEST_SKIP() << "kernel doesn't support UDP_GRO and UDP_SEGMENT";
+  }
+
+  ASSERT_NO_FATAL_FAILURE(bulk_transfer(1 << 20));
+
+  // the server received coalesced packet trains, and split each back into
+  // its individual packets
+  const auto sstats = conn->acceptor.stats();
+  EXPECT_LT(0, sstats.coalesced_receives);
+  EXPECT_LT(sstats.coalesced_receives, sstats.packets_received);
+}
+
+TEST_F(ServerTransport, io_uring)
+{
+  // falls back to the reactor where io_uring isn't available
+  ASSERT_NO_FATAL_FAILURE(connect(quic::default_server_settings(),
+                                  quic::default_client_settings(),
+                                  quic::packet_io::io_uring));
+  if (!conn->acceptor.features().io_uring) {
+    GTEST_SKIP() << "kernel doesn't support io_uring multishot receive";
+  }
+  EXPECT_TRUE(conn->client.features().io_uring);
+
+  const auto sstats = conn->acceptor.stats();
+  EXPECT_LT(0, sstats.receive_calls);
+  EXPECT_LT(0, sstats.packets_received);
+  EXPECT_LT(0, sstats.packets_sent);
+  const auto cstats = conn->client.stats();
+  EXPECT_LT(0, cstats.receive_calls);
+  EXPECT_LT(0, cstats.packets_received);
+  EXPECT_LT(0, cstats.packets_sent);
+
+  // another acceptor on the same server can use the reactor
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto acceptor = quic::acceptor{conn->server, udp::endpoint{localhost, 0},
+                                 ssl, quic::packet_io::reactor};
+  acceptor.listen(16);
+  std::optional<error_code> accept_ec;
+  auto sconn = quic::connection{acceptor};
+  acceptor.async_accept(sconn, capture(accept_ec));
+
+  auto client = quic::client{context.get_executor(), udp::endpoint{}, sslc};
+  auto cconn = quic::connection{client, acceptor.local_endpoint(), "host"};
+  std::optional<error_code> stream_connect_ec;
+  auto cstream = quic::stream{cconn};
+  cconn.async_connect(cstream, capture(stream_connect_ec));
+  context.poll();
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(ok, *accept_ec);
+  EXPECT_LT(0, acceptor.stats().packets_received);
+  EXPECT_FALSE(acceptor.features().io_uring);
+  EXPECT_TRUE(conn->acceptor.features().io_uring);
+
+  // io_uring isn't reported until a packet arrives that way
+  auto idle = quic::acceptor{conn->server, udp::endpoint{localhost, 0},
+                             ssl, quic::packet_io::io_uring};
+  idle.listen(16);
+  context.poll();
+  EXPECT_FALSE(idle.features().io_uring);
+}
+
+TEST_F(ServerTransport, reuse_port_shards)
+{
+  auto ex = context.get_executor();
+
+  constexpr unsigned num_shards = 2;
+  auto settings = std::array<quic::settings, num_shards>{};
+  for (uint8_t i = 0; i < num_shards; i++) {
+    settings[i] = quic::default_server_settings();
+    settings[i].reuse_port = true;
+    settings[i].generate_connection_id =
+        quic::sharded_connection_id_generator(i);
+  }
+
+  // bind each shard's socket to the same port, in shard order
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto endpoint = udp::endpoint{localhost, 0};
+  auto sockets = std::vector<udp::socket>{};
+  for (unsigned i = 0; i < num_shards; i++) {
+    auto& socket = sockets.emplace_back(ex, endpoint.protocol());
+    error_code ec;
+    quic::prepare_socket(socket, true, settings[i], ec);
+    ASSERT_EQ(ok, ec);
+    socket.bind(endpoint);
+    endpoint = socket.local_endpoint();
+  }
+  error_code ec;
+  quic::attach_reuseport_cbpf(sockets[0], num_shards, ec);
+  ASSERT_EQ(ok, ec);
+
+  auto server0 = quic::server{ex, settings[0]};
+  auto acceptor0 = quic::acceptor{server0, std::move(sockets[0]), ssl};
+  acceptor0.listen(16);
+  auto server1 = quic::server{ex, settings[1]};
+  auto acceptor1 = quic::acceptor{server1, std::move(sockets[1]), ssl};
+  acceptor1.listen(16);
+
+  std::optional<error_code> accept0_ec;
+  auto sconn0 = quic::connection{acceptor0};
+  acceptor0.async_accept(sconn0, capture(accept0_ec));
+  std::optional<error_code> accept1_ec;
+  auto sconn1 = quic::connection{acceptor1};
+  acceptor1.async_accept(sconn1, capture(accept1_ec));
+
+  auto client = quic::client{ex, udp::endpoint{}, sslc};
+  auto cconn = quic::connection{client, endpoint, "host"};
+
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+  // the connection was accepted by one of the shards
+  ASSERT_NE(accept0_ec.has_value(), accept1_ec.has_value());
+  const uint8_t shard = accept0_ec ? 0 : 1;
+  auto& sconn = accept0_ec ? sconn0 : sconn1;
+  EXPECT_EQ(ok, accept0_ec ? *accept0_ec : *accept1_ec);
+  // with a connection id from that shard
+  const auto id = sconn.id();
+  ASSERT_LT(0, id.size());
+  EXPECT_EQ(shard, id[0]);
+
+  // short-header packets for the connection are steered to the same shard
+  std::optional<error_code> sstream_accept_ec;
+  auto sstream = quic::stream{sconn};
+  sconn.async_accept(sstream, capture(sstream_accept_ec));
+
+  std::optional<error_code> cstream_connect_ec;
+  auto cstream = quic::stream{cconn};
+  cconn.async_connect(cstream, capture(cstream_connect_ec));
+  context.poll();
+  ASSERT_TRUE(cstream_connect_ec);
+  EXPECT_EQ(ok, *cstream_connect_ec);
+
+  const auto data = std::string_view{"1234"};
+  std::optional<error_code> cstream_write_ec;
+  cstream.async_write_some(boost::asio::buffer(data),
+      [&] (error_code ec, size_t) { cstream_write_ec = ec; });
+  cstream.flush();
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+  ASSERT_TRUE(cstream_write_ec);
+  EXPECT_EQ(ok, *cstream_write_ec);
+  ASSERT_TRUE(sstream_accept_ec);
+  EXPECT_EQ(ok, *sstream_accept_ec);
+}
+
 } // namespace nexus
@@ -0,0 +1,149 @@
+#include <nexus/quic/sharded_server.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <lsquic.h>
+#include <nexus/ssl.hpp>
+#include <nexus/quic/client.hpp>
+#include <nexus/quic/connection.hpp>
+#include <nexus/quic/stream.hpp>
+#include <nexus/global_init.hpp>
+
+#include "certificate.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out,
+             std::unique_ptr<quic::connection>& conn) {
+  return [&] (error_code ec, std::unique_ptr<quic::connection> c) {
+    out = ec;
+    conn = std::move(c);
+  };
+}
+
+// the shards run on their own threads, so wait for a completion
+template <typename Predicate>
+void run_until(boost::asio::io_context& context, Predicate&& pred) {
+  while (!pred() && context.run_one_for(std::chrono::seconds(5))) {}
+}
+
+} // anonymous namespace
+
+TEST(sharded_server, accept)
+{
+  auto context = boost::asio::io_context{};
+  auto ex = context.get_executor();
+  auto global = global::init_client_server();
+
+  auto ssl = test::init_server_context("\04test");
+  auto sslc = test::init_client_context("\04test");
+
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto server = quic::sharded_server{ex, udp::endpoint{localhost, 0}, ssl,
+                                     quic::default_server_settings(), 2};
+  EXPECT_EQ(2u, server.size());
+  const auto endpoint = server.local_endpoint();
+  server.listen(16);
+
+  std::optional<error_code> accept_ec;
+  std::unique_ptr<quic::connection> sconn;
+  server.async_accept(capture(accept_ec, sconn));
+
+  auto client = quic::client{ex, udp::endpoint{}, sslc};
+  auto cconn = quic::connection{client, endpoint, "host"};
+
+  std::optional<error_code> stream_connect_ec;
+  auto cstream = quic::stream{cconn};
+  cconn.async_connect(cstream, [&] (error_code ec) { stream_connect_ec = ec; });
+
+  run_until(context, [&] { return accept_ec.has_value(); });
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(ok, *accept_ec);
+  ASSERT_TRUE(sconn);
+  EXPECT_TRUE(sconn->is_open());
+  // the connection id names the shard that accepted it
+  const auto id = sconn->id();
+  ASSERT_LT(0, id.size());
+  EXPECT_GT(server.size(), id[0]);
+
+  sconn.reset();
+  cconn.close();
+  server.close();
+}
+
+TEST(sharded_server, close_aborts_accept)
+{
+  auto context = boost::asio::io_context{};
+  auto ex = context.get_executor();
+  auto global = global::init_client_server();
+
+  auto ssl = test::init_server_context("\04test");
+
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  auto server = quic::sharded_server{ex, udp::endpoint{localhost, 0}, ssl,
+                                     quic::default_server_settings(), 2};
+  server.listen(16);
+
+  std::optional<error_code> accept_ec;
+  std::unique_ptr<quic::connection> sconn;
+  server.async_accept(capture(accept_ec, sconn));
+
+  context.poll();
+  ASSERT_FALSE(context.stopped());
+  EXPECT_FALSE(accept_ec);
+
+  server.close();
+  context.poll();
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(quic::connection_error::aborted, *accept_ec);
+  EXPECT_FALSE(sconn);
+
+  // accepts after close() fail immediately
+  accept_ec.reset();
+  server.async_accept(capture(accept_ec, sconn));
+  context.poll();
+  ASSERT_TRUE(accept_ec);
+  EXPECT_EQ(quic::connection_error::aborted, *accept_ec);
+}
+
+TEST(sharded_server, listen_twice)
+{
+  auto context = boost::asio::io_context{};
+  auto ex = context.get_executor();
+  auto global = global::init_client_server();
+
+  auto ssl = test::init_server_context("\04test");
+
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  // uses default_server_settings()
+  auto server = quic::sharded_server{ex, udp::endpoint{localhost, 0}, ssl, 2};
+  EXPECT_EQ(2u, server.size());
+  server.listen(16);
+  EXPECT_THROW(server.listen(16), system_error);
+
+  server.close();
+  EXPECT_THROW(server.listen(16), system_error);
+}
+
+TEST(sharded_server, single_threaded)
+{
+  auto context = boost::asio::io_context{};
+  auto global = global::init_client_server();
+  auto ssl = test::init_server_context("\04test");
+
+  // connections are claimed from other threads than their shard's
+  auto settings = quic::default_server_settings();
+  settings.single_threaded = true;
+  const auto localhost = boost::asio::ip::make_address("127.0.0.1");
+  EXPECT_THROW(quic::sharded_server(context.get_executor(),
+                                    udp::endpoint{localhost, 0}, ssl,
+                                    settings, 2),
+               quic::bad_setting);
+}
+
+} // namespace nexus
@@ -0,0 +1,98 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+} // anonymous namespace
+
+using StreamRead = test::MemoryNetwork;
+
+TEST_F(StreamRead, inline_read)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+
+  // more than the stream's initial flow control window, so the client
+  // blocks until the server reads
+  const auto data = std::string(256 * 1024, 'x');
+  std::optional<error_code> write_ec;
+  conn->cstream.async_write_last(boost::asio::buffer(data),
+      [&] (error_code ec, size_t) { write_ec = ec; });
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  context.poll();
+  ASSERT_FALSE(write_ec);
+
+  // the buffered data is read without processing the connection, so
+  // nothing is sent until the next turn of the event loop
+  auto buffer = std::vector<char>(data.size());
+  std::optional<error_code> read_ec;
+  size_t read_bytes = 0;
+  const auto packets_sent = conn->acceptor.stats().packets_sent;
+  conn->sstream.async_read_some(boost::asio::buffer(buffer),
+      [&] (error_code ec, size_t n) { read_ec = ec; read_bytes = n; });
+  EXPECT_EQ(packets_sent, conn->acceptor.stats().packets_sent);
+
+  // then the read completes and the window update is sent
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_LT(0, read_bytes);
+  EXPECT_GT(data.size(), read_bytes);
+  EXPECT_LT(packets_sent, conn->acceptor.stats().packets_sent);
+
+  auto received = std::string(buffer.data(), read_bytes);
+  ASSERT_NO_FATAL_FAILURE(read_all(conn->sstream, received));
+  EXPECT_EQ(data, received);
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+}
+
+TEST_F(StreamRead, wait_for_data)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+  const auto data = std::string_view{"1234"};
+  std::optional<error_code> write_ec;
+  conn->cstream.async_write_some(boost::asio::buffer(data),
+      [&] (error_code ec, size_t) { write_ec = ec; });
+  conn->cstream.flush();
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+
+  auto buffer = std::array<char, 16>{};
+  auto read = [&] (std::optional<error_code>& ec, size_t& bytes) {
+    conn->sstream.async_read_some(boost::asio::buffer(buffer),
+        [&] (error_code e, size_t n) { ec = e; bytes = n; });
+  };
+  std::optional<error_code> read_ec;
+  size_t read_bytes = 0;
+  read(read_ec, read_bytes);
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(data, std::string_view(buffer.data(), read_bytes));
+
+  // nothing is buffered, so the read waits for more data
+  read_ec.reset();
+  read(read_ec, read_bytes);
+  context.poll();
+  EXPECT_FALSE(read_ec);
+
+  conn->cstream.async_write_some(boost::asio::buffer(data),
+      [&] (error_code ec, size_t) { write_ec = ec; });
+  conn->cstream.flush();
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(data, std::string_view(buffer.data(), read_bytes));
+}
+
+} // namespace nexus
@@ -0,0 +1,87 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <optional>
+#include <string>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out) {
+  return [&] (error_code ec, size_t bytes = 0) { out = ec; };
+}
+
+} // anonymous namespace
+
+using StreamReadView = test::MemoryNetwork;
+
+TEST_F(StreamReadView, read_some_view)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+  auto& cstream = conn->cstream;
+  auto& sstream = conn->sstream;
+  {
+    std::optional<error_code> cstream_write_ec;
+    cstream.async_write_some(boost::asio::buffer(std::string_view{"1234"}),
+                             capture(cstream_write_ec));
+    cstream.shutdown(1);
+    context.poll();
+    ASSERT_FALSE(context.stopped());
+    ASSERT_TRUE(cstream_write_ec);
+    EXPECT_EQ(ok, *cstream_write_ec);
+  }
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+
+  std::string received;
+  auto visitor = [&received] (boost::asio::const_buffer data) {
+    // consume only the first two bytes of each view
+    const size_t bytes = std::min<size_t>(data.size(), 2);
+    received.append(static_cast<const char*>(data.data()), bytes);
+    return bytes;
+  };
+  std::optional<error_code> read_ec;
+  size_t read_bytes = 0;
+  auto capture_read = [&] (error_code ec, size_t bytes) {
+    read_ec = ec;
+    read_bytes = bytes;
+  };
+  sstream.async_read_some_view(visitor, capture_read);
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(2, read_bytes);
+  EXPECT_EQ("12", received);
+
+  // a visitor that consumes nothing completes without error
+  read_ec.reset();
+  sstream.async_read_some_view(
+      [] (boost::asio::const_buffer) { return size_t{0}; }, capture_read);
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(0, read_bytes);
+
+  // the rest is already buffered
+  read_ec.reset();
+  sstream.async_read_some_view(visitor, capture_read);
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(2, read_bytes);
+  EXPECT_EQ("1234", received);
+
+  // end of stream
+  read_ec.reset();
+  sstream.async_read_some_view(visitor, capture_read);
+  context.poll();
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(quic::stream_error::eof, *read_ec);
+  EXPECT_EQ(0, read_bytes);
+}
+
+} // namespace nexus
@@ -0,0 +1,74 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+} // anonymous namespace
+
+using StreamSendFile = test::MemoryNetwork;
+
+TEST_F(StreamSendFile, send_file)
+{
+  // a file larger than the stream's initial flow control window
+  char path[] = "/tmp/nexus_send_file_XXXXXX";
+  const int fd = ::mkstemp(path);
+  ASSERT_NE(-1, fd);
+  ::unlink(path);
+  auto contents = std::string(256 * 1024, '\0');
+  for (size_t i = 0; i < contents.size(); i++) {
+    contents[i] = 'a' + (i % 26);
+  }
+  ASSERT_EQ(contents.size(), ::write(fd, contents.data(), contents.size()));
+
+  ASSERT_NO_FATAL_FAILURE(connect());
+  auto& cstream = conn->cstream;
+
+  // a byte range that doesn't start on a page boundary
+  const uint64_t offset = 1000;
+  const size_t length = 200 * 1024;
+  std::optional<error_code> send_ec;
+  size_t send_bytes = 0;
+  cstream.async_send_file(fd, offset, length, [&] (error_code ec, size_t n) {
+        send_ec = ec;
+        send_bytes = n;
+        cstream.shutdown(1);
+      });
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+
+  std::string received;
+  ASSERT_NO_FATAL_FAILURE(read_all(conn->sstream, received));
+  ASSERT_TRUE(send_ec);
+  EXPECT_EQ(ok, *send_ec);
+  EXPECT_EQ(length, send_bytes);
+  EXPECT_EQ(contents.substr(offset, length), received);
+
+  // ranges past the end of the file are rejected before the stream is
+  // written, even though it's shut down
+  send_ec.reset();
+  cstream.async_send_file(fd, 0, contents.size() + 1,
+      [&] (error_code ec, size_t n) { send_ec = ec; });
+  context.poll();
+  ASSERT_TRUE(send_ec);
+  EXPECT_EQ(make_error_code(errc::invalid_argument), *send_ec);
+
+  send_ec.reset();
+  cstream.async_send_file(fd, contents.size() + 1, 0,
+      [&] (error_code ec, size_t n) { send_ec = ec; });
+  context.poll();
+  ASSERT_TRUE(send_ec);
+  EXPECT_EQ(make_error_code(errc::invalid_argument), *send_ec);
+  ::close(fd);
+}
+
+} // namespace nexus
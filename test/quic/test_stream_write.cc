@@ -0,0 +1,82 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+} // anonymous namespace
+
+using StreamWrite = test::MemoryNetwork;
+
+TEST_F(StreamWrite, write_with_credit)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+
+  // the stream has credit, so the whole write completes at once
+  const auto data = std::string_view{"1234"};
+  std::optional<error_code> write_ec;
+  size_t write_bytes = 0;
+  conn->cstream.async_write_some(boost::asio::buffer(data),
+      [&] (error_code ec, size_t n) { write_ec = ec; write_bytes = n; });
+  conn->cstream.shutdown(1);
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  EXPECT_EQ(data.size(), write_bytes);
+
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  std::string received;
+  ASSERT_NO_FATAL_FAILURE(read_all(conn->sstream, received));
+  EXPECT_EQ(data, received);
+}
+
+TEST_F(StreamWrite, write_blocked)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+
+  // more than the stream's initial flow control window. the first write
+  // takes the credit that's available
+  const auto data = std::string(256 * 1024, 'x');
+  std::optional<error_code> write_ec;
+  size_t write_bytes = 0;
+  conn->cstream.async_write_some(boost::asio::buffer(data),
+      [&] (error_code ec, size_t n) { write_ec = ec; write_bytes = n; });
+  conn->cstream.flush();
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  ASSERT_LT(0, write_bytes);
+  ASSERT_GT(data.size(), write_bytes);
+  const size_t first = write_bytes;
+
+  // without credit, the next write waits until the server reads
+  write_ec.reset();
+  conn->cstream.async_write_some(boost::asio::buffer(data) + first,
+      [&] (error_code ec, size_t n) { write_ec = ec; write_bytes = n; });
+  context.poll();
+  EXPECT_FALSE(write_ec);
+
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  auto buffer = std::string(data.size(), '\0');
+  std::optional<error_code> read_ec;
+  size_t read_bytes = 0;
+  conn->sstream.async_read_some(boost::asio::buffer(buffer),
+      [&] (error_code ec, size_t n) { read_ec = ec; read_bytes = n; });
+  while (!write_ec && context.poll()) {}
+  ASSERT_TRUE(read_ec);
+  EXPECT_EQ(ok, *read_ec);
+  EXPECT_EQ(first, read_bytes);
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  EXPECT_LT(0, write_bytes);
+}
+
+} // namespace nexus
@@ -0,0 +1,67 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out) {
+  return [&] (error_code ec, size_t bytes = 0) { out = ec; };
+}
+
+// a source that hands out the remainder of a string
+struct string_source {
+  std::string_view remaining;
+  size_t size() { return remaining.size(); }
+  size_t read(void* data, size_t count) {
+    count = std::min(count, remaining.size());
+    ::memcpy(data, remaining.data(), count);
+    remaining.remove_prefix(count);
+    return count;
+  }
+};
+
+} // anonymous namespace
+
+using StreamWriteFrom = test::MemoryNetwork;
+
+TEST_F(StreamWriteFrom, write_some_from)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+
+  auto source = string_source{"1234"};
+  std::optional<error_code> write_ec;
+  size_t write_bytes = 0;
+  conn->cstream.async_write_some_from(source,
+      [&] (error_code ec, size_t bytes) {
+        write_ec = ec;
+        write_bytes = bytes;
+      });
+  conn->cstream.shutdown(1);
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  EXPECT_EQ(4, write_bytes);
+  EXPECT_TRUE(source.remaining.empty());
+
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+  auto data = std::array<char, 5>{};
+  std::optional<error_code> sstream_read_ec;
+  conn->sstream.async_read_some(boost::asio::buffer(data),
+                                capture(sstream_read_ec));
+  context.poll();
+  ASSERT_TRUE(sstream_read_ec);
+  EXPECT_EQ(ok, *sstream_read_ec);
+  EXPECT_STREQ(data.data(), "1234");
+}
+
+} // namespace nexus
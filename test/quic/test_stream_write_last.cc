@@ -0,0 +1,64 @@
+#include <nexus/quic/stream.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "memory_connection.hpp"
+
+namespace nexus {
+
+namespace {
+
+const error_code ok;
+
+auto capture(std::optional<error_code>& out) {
+  return [&] (error_code ec, size_t bytes = 0) { out = ec; };
+}
+
+} // anonymous namespace
+
+using StreamWriteLast = test::MemoryNetwork;
+
+TEST_F(StreamWriteLast, write_last)
+{
+  ASSERT_NO_FATAL_FAILURE(connect());
+  auto& cstream = conn->cstream;
+
+  // more than the stream's initial flow control window, split across
+  // several buffers
+  auto first = std::string(64 * 1024, 'a');
+  auto second = std::string(64 * 1024, 'b');
+  const auto buffers = std::array<boost::asio::const_buffer, 3>{
+    boost::asio::buffer(first),
+    boost::asio::buffer(std::string_view{"1234"}),
+    boost::asio::buffer(second)
+  };
+  const size_t total = boost::asio::buffer_size(buffers);
+
+  std::optional<error_code> write_ec;
+  size_t write_bytes = 0;
+  cstream.async_write_last(buffers, [&] (error_code ec, size_t bytes) {
+        write_ec = ec;
+        write_bytes = bytes;
+      });
+  ASSERT_NO_FATAL_FAILURE(accept_stream());
+
+  std::string received;
+  ASSERT_NO_FATAL_FAILURE(read_all(conn->sstream, received));
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(ok, *write_ec);
+  EXPECT_EQ(total, write_bytes);
+  EXPECT_EQ(first + "1234" + second, received);
+
+  // the stream was shut down for writes
+  write_ec.reset();
+  cstream.async_write_some(boost::asio::buffer(std::string_view{"5"}),
+                           capture(write_ec));
+  context.poll();
+  ASSERT_TRUE(write_ec);
+  EXPECT_EQ(make_error_code(errc::bad_file_descriptor), *write_ec);
+}
+
+} // namespace nexus